@@ -0,0 +1,374 @@
+// Copyright (c) 2022-2024 Zero <zero.kwok@foxmail.com>
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// 导航原语的微基准测试
+//
+// 按指定的深度、扇出以及每个页面挂载的容器数生成页面树, 逐一测量
+// page(), pageSwitch(), pageInvoke(), subpages(), visitPages(), toShortcodePath(),
+// fromShortcodePath(), RouteId 与短码路径的互相转换, routePath(), parseLink()
+// 以及 ShortcodeAllocator::allocate()(在独立的分配器上分配后立即释放) 的
+// 每次操作耗时(ns/op)和每次操作的内存分配次数(allocs/op).
+//
+// 用法:
+//   QT_QPA_PLATFORM=offscreen pages_manager_bench [--depth N --fanout N --containers N]
+//                                                 [--iterations N] [--max-pages N] [--json FILE]
+// 未指定树形时, 依次运行 10 ~ 111k 个页面的预设树形, 可以用 --max-pages 跳过较大的树形.
+
+#include "pages_manager.hpp"
+#include <QtWidgets>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+namespace {
+
+std::atomic<qint64> g_allocations{ 0 };
+quintptr g_sink = 0;
+
+} // namespace
+
+// 统计内存分配次数:
+// glibc 下直接替换 malloc 系列函数, 这样 Qt 容器内部的分配也会被统计到;
+// 其他平台仅能统计 operator new.
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void  __libc_free(void* ptr);
+
+void* malloc(size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) noexcept {
+    __libc_free(ptr);
+}
+}
+#else
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+#endif
+
+class BenchPage : public AbstractPage
+{
+public:
+    QVariant pageInvoke(QString callerPath, const QVariantMap& params) override {
+        return params.size();
+    }
+};
+
+//! @brief 页面树的形状
+struct TreeShape
+{
+    int depth;      //!< 页面层级数
+    int fanout;     //!< 每个容器中的页面数
+    int containers; //!< 每个非叶子页面挂载的容器数
+
+    qint64 pages() const {
+        qint64 total = 0, level = fanout;
+        for (int i = 0; i < depth; ++i) {
+            total += level;
+            level *= qint64(fanout) * containers;
+        }
+        return total;
+    }
+};
+
+//! @brief 生成的页面树
+struct Tree
+{
+    PagesContainer*      root = nullptr;
+    QStringList          leaves;  //!< 最深一层的页面路径(已打乱)
+    QStringList          codes;   //!< leaves 对应的短码路径
+    QStringList          names;   //!< 所有出现过的页面名称
+    QList<AbstractPage*> pages;   //!< 所有页面实例(已打乱)
+};
+
+struct Result
+{
+    QString name;
+    qint64  iterations;
+    double  nsPerOp;
+    double  allocsPerOp;
+};
+
+static QString pageName(int container, int index) {
+    return container == 0
+        ? QString("p%1").arg(index)
+        : QString("c%1p%2").arg(container).arg(index);
+}
+
+static void buildContainer(Tree& tree, PagesContainer* container, const TreeShape& shape, 
+    int level, int containerIndex, const QString& prefix)
+{
+    for (int i = 0; i < shape.fanout; ++i)
+    {
+        auto name = pageName(containerIndex, i);
+        auto page = new BenchPage();
+        container->installPage(name, page);
+        tree.pages << page;
+
+        auto path = prefix + "/" + name;
+        if (level + 1 == shape.depth) {
+            tree.leaves << path;
+            continue;
+        }
+
+        for (int c = 0; c < shape.containers; ++c) {
+            auto sub = new PagesContainer(page);
+            page->installContainer(sub);
+            buildContainer(tree, sub, shape, level + 1, c, path);
+        }
+    }
+}
+
+template<class F>
+static Result measure(const QString& name, qint64 iterations, F&& fn)
+{
+    // 预热: 触发惰性初始化, 填充缓存
+    for (qint64 i = 0; i < qMin<qint64>(iterations, 4096); ++i)
+        fn(i);
+
+    qint64 allocations = g_allocations.load();
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 i = 0; i < iterations; ++i)
+        fn(i);
+    qint64 elapsed = timer.nsecsElapsed();
+    allocations = g_allocations.load() - allocations;
+
+    return { name, iterations, double(elapsed) / iterations, double(allocations) / iterations };
+}
+
+static QList<Result> runShape(const TreeShape& shape, qint64 iterations)
+{
+    QList<Result> results;
+    PagesManager& manager = PagesManager::instance();
+    std::mt19937 random(42);
+
+    Tree tree;
+    tree.root = new PagesContainer();
+    manager.setRootContainer(tree.root);
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 allocations = g_allocations.load();
+    buildContainer(tree, tree.root, shape, 0, 0, {});
+    results << Result{ "install", tree.pages.size(),
+        double(timer.nsecsElapsed()) / tree.pages.size(),
+        double(g_allocations.load() - allocations) / tree.pages.size() };
+
+    std::shuffle(tree.leaves.begin(), tree.leaves.end(), random);
+    std::shuffle(tree.pages.begin(), tree.pages.end(), random);
+    for (const auto& leaf : tree.leaves)
+        tree.codes << manager.toShortcodePath(leaf);
+    for (int c = 0; c < shape.containers; ++c)
+        for (int i = 0; i < shape.fanout; ++i)
+            tree.names << pageName(c, i);
+
+    const QStringList& leaves = tree.leaves;
+    const QStringList& codes  = tree.codes;
+    const QStringList& names  = tree.names;
+    const QList<AbstractPage*>& pages = tree.pages;
+    const QVariantMap params{ { "key", 1 } };
+
+    results << measure("page", iterations, [&](qint64 i) {
+        g_sink += quintptr(manager.page(leaves[i % leaves.size()]));
+    });
+    results << measure("pageSwitch", iterations, [&](qint64 i) {
+        manager.pageSwitch({}, leaves[i % leaves.size()], {});
+    });
+    results << measure("pageInvoke", iterations, [&](qint64 i) {
+        g_sink += manager.pageInvoke({}, leaves[i % leaves.size()], params).toInt();
+    });
+    results << measure("subpages", iterations, [&](qint64 i) {
+        g_sink += pages[i % pages.size()]->subpages().size();
+    });
+    results << measure("visitPages", iterations, [&](qint64 i) {
+        manager.visitPages([](const QString&, AbstractPage* page, int) {
+            g_sink += quintptr(page);
+            return true;
+        }, pages[i % pages.size()]);
+    });
+    results << measure("toShortcodePath", iterations, [&](qint64 i) {
+        g_sink += manager.toShortcodePath(leaves[i % leaves.size()]).size();
+    });
+    results << measure("fromShortcodePath", iterations, [&](qint64 i) {
+        g_sink += manager.fromShortcodePath(codes[i % codes.size()]).size();
+    });
+    const QVector<RouteId> routes = RouteId::fromShortcodePaths(codes);
+    results << measure("routeEncode", iterations, [&](qint64 i) {
+        g_sink += RouteId::fromShortcodePath(codes[i % codes.size()]).lo();
+    });
+    results << measure("routeDecode", iterations, [&](qint64 i) {
+        QChar buffer[RouteId::MaxLength];
+        g_sink += routes[i % routes.size()].toChars(buffer);
+    });
+    results << measure("routePath", iterations, [&](qint64 i) {
+        g_sink += manager.routePath(routes[i % routes.size()]).size();
+    });
+    QStringList links;
+    for (const auto& leaf : leaves)
+        links << leaf + "?id=42&sort=date";
+    results << measure("parseLink", iterations, [&](qint64 i) {
+        g_sink += manager.parseLink(links[i % links.size()]).params.size();
+    });
+    // 独立的分配器, 每次分配后立即释放, 使每次操作都是真正的分配(而不是已有名称的引用计数)
+    ShortcodeAllocator allocator;
+    results << measure("allocate", iterations, [&](qint64 i) {
+        const QString& name = names[i % names.size()];
+        g_sink += allocator.allocate(name).size();
+        allocator.release(name);
+    });
+
+    // 卸载页面树并清空全局分配器, 下一个树形从空的短码空间开始
+    tree.root->uninstallPages(tree.root->pages(false).keys());
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    delete tree.root;
+    ShortcodeAllocator::instance().clear();
+    return results;
+}
+
+int main(int argc, char* argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Microbenchmark for pages_manager navigation primitives");
+    parser.addHelpOption();
+    parser.addOption({ "depth", "Page tree depth.", "n" });
+    parser.addOption({ "fanout", "Pages per container.", "n" });
+    parser.addOption({ "containers", "Containers per non-leaf page.", "n" });
+    parser.addOption({ "iterations", "Iterations per primitive (default 20000).", "n", "20000" });
+    parser.addOption({ "max-pages", "Skip preset trees larger than this (default 200000).", "n", "200000" });
+    parser.addOption({ "json", "Write results as JSON to this file.", "file" });
+    parser.process(a);
+
+    QList<TreeShape> shapes;
+    if (parser.isSet("depth") || parser.isSet("fanout") || parser.isSet("containers")) {
+        shapes << TreeShape{
+            parser.isSet("depth") ? parser.value("depth").toInt() : 3,
+            parser.isSet("fanout") ? parser.value("fanout").toInt() : 10,
+            parser.isSet("containers") ? parser.value("containers").toInt() : 1 };
+    }
+    else {
+        shapes << TreeShape{ 1, 10, 1 }   // 10
+               << TreeShape{ 2, 10, 1 }   // 110
+               << TreeShape{ 3, 10, 1 }   // 1,110
+               << TreeShape{ 3, 5, 2 }    // 555, 多容器
+               << TreeShape{ 4, 10, 1 }   // 11,110
+               << TreeShape{ 4, 5, 2 }    // 5,555, 多容器
+               << TreeShape{ 5, 10, 1 };  // 111,110
+    }
+
+    const qint64 iterations = qMax<qint64>(1, parser.value("iterations").toLongLong());
+    const qint64 maxPages = parser.value("max-pages").toLongLong();
+
+    QJsonArray runs;
+    for (const auto& shape : shapes)
+    {
+        if (shape.depth < 1 || shape.fanout < 1 || shape.containers < 1)
+            continue;
+        if (shape.pages() > maxPages && shapes.size() > 1)
+            continue;
+
+        std::printf("\n# depth=%d fanout=%d containers=%d pages=%lld\n",
+            shape.depth, shape.fanout, shape.containers, (long long)shape.pages());
+        std::printf("%-20s %12s %14s %14s\n", "primitive", "iterations", "ns/op", "allocs/op");
+
+        QJsonArray primitives;
+        for (const auto& r : runShape(shape, iterations))
+        {
+            std::printf("%-20s %12lld %14.1f %14.2f\n", qPrintable(r.name),
+                (long long)r.iterations, r.nsPerOp, r.allocsPerOp);
+
+            QJsonObject item;
+            item["primitive"] = r.name;
+            item["iterations"] = r.iterations;
+            item["ns_per_op"] = r.nsPerOp;
+            item["allocs_per_op"] = r.allocsPerOp;
+            primitives.append(item);
+        }
+
+        QJsonObject run;
+        run["depth"] = shape.depth;
+        run["fanout"] = shape.fanout;
+        run["containers"] = shape.containers;
+        run["pages"] = shape.pages();
+        run["results"] = primitives;
+        runs.append(run);
+    }
+
+    if (parser.isSet("json"))
+    {
+        QJsonObject root;
+        root["benchmark"] = "pages_manager_bench";
+        root["qt_version"] = qVersion();
+        root["allocation_counter"] =
+#if defined(__GLIBC__)
+            "malloc";
+#else
+            "operator new";
+#endif
+        root["runs"] = runs;
+
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::fprintf(stderr, "failed to write %s\n", qPrintable(parser.value("json")));
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+    }
+
+    return g_sink == quintptr(-1) ? 2 : 0;
+}
@@ -73,30 +73,13 @@ protected:
     QWidget* _content;
 };
 
-QStandardItem* FeedTreeModel(QStandardItem* data, QMap<QString, AbstractPage*> pages)
-{
-    QList<QStandardItem*> items;
-    for (auto it = pages.constBegin(); it != pages.constEnd(); ++it)
-    {
-        auto item = new QStandardItem(it.key());
-        item->setData(it.value()->pagePath(), Qt::UserRole);
-        items << item;
-        FeedTreeModel(item, it.value()->subpages());
-    }
-
-    if (items.size())
-        data->appendRows(items);
-
-    return data;
-};
-
 int main(int argc, char* argv[])
 {
     QApplication a(argc, argv);
 
     QDialog dialog;
     auto list = new QTreeView();
-    auto data = new QStandardItemModel(&a);
+    auto data = new PagesTreeModel(&a);
     
     auto vbox = new QVBoxLayout();
     
@@ -174,9 +157,10 @@ int main(int argc, char* argv[])
     if (auto page = pageCast("/view"))
     {
         auto viewContainer = new PagesContainer();
-        viewContainer->installPage("photos", new MyPage());
-        viewContainer->installPage("contacts", new MyPage());
-        viewContainer->installPage("messages", new MyPage());
+        // 延迟构造: 页面实例在首次被访问时才创建
+        viewContainer->installPage("photos", [] { return new MyPage(); });
+        viewContainer->installPage("contacts", [] { return new MyPage(); });
+        viewContainer->installPage("messages", [] { return new MyPage(); });
         page->setupWidget(viewContainer);
         page->installContainer(viewContainer);
     }
@@ -212,15 +196,11 @@ int main(int argc, char* argv[])
     //////////////////////////////////////////////////////////////////////////
 
     PagesManager::instance().pageGoto({}, "/home", {});
-    data->setHorizontalHeaderLabels(QStringList() << "path");
-    data->appendRow(FeedTreeModel(
-        new QStandardItem("root"), 
-        PagesManager::instance().topPages()));
     list->expandAll();
 
     QObject::connect(list, &QAbstractItemView::doubleClicked, 
         &PagesManager::instance(), [=](QModelIndex index) {
-            auto path = index.data(Qt::UserRole).toString();
+            auto path = index.data(PagesTreeModel::PathRole).toString();
             if (path.size())
                 PagesManager::instance().pageGoto(
                     PagesManager::instance().currentPage()->pagePath(), path, {});
@@ -228,10 +208,7 @@ int main(int argc, char* argv[])
 
     QObject::connect(&PagesManager::instance(), &PagesManager::currentPageChanged,
         list, [=](QString oldPagePath, QString newPagePath) {
-            QModelIndexList indexes = data->match(data->index(0, 0, QModelIndex()),
-                Qt::UserRole, newPagePath, -1, Qt::MatchStartsWith | Qt::MatchRecursive);
-            if (indexes.size())
-                list->setCurrentIndex(indexes.first());
+            list->setCurrentIndex(data->indexOf(newPagePath));
         });
 
     dialog.show();
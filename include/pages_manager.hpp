@@ -23,17 +23,71 @@
 
 #include <QSet>
 #include <QMap>
+#include <QHash>
+#include <QVector>
+#include <QPair>
 #include <QStack>
+#include <QContiguousCache>
+#include <QVarLengthArray>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QFutureInterface>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QIODevice>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QScopedPointer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
 #include <QStackedWidget>
+#include <QCache>
+#include <QLocale>
+#include <QUrl>
+#include <QPixmap>
+#include <QLabel>
+#include <QAbstractItemModel>
+#include <QMetaMethod>
 #include <QApplication>
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <typeinfo>
 
-//! @brief 短码分配器(单例)
-//! @note 为页面名称分配全局唯一的两字符短码
+//! @brief 短码分配器
+//! @note instance() 返回全局作用域, 为页面名称分配全树唯一的短码;
+//!       也可以单独构造实例, 经 PagesContainer::setShortcodeScope() 作为容器的局部作用域.
+//!
+//! 短码字母表为 [a-z0-9A-Z] 共 62 个字符, 由首字符决定短码长度, 因此短码路径无需分隔符:
+//!   - [a-z0-9] 开头为两字符短码, 共 36*62 = 2232 个;
+//!   - [A-Z] 开头为三字符扩展短码, 共 26*62*62 = 99944 个, 两字符短码耗尽后才会使用,
+//!     可以通过 setExtendedCodes(false) 禁用.
+//! 每个短码对应一个槽位, 槽位 -> 名称使用按短码字符索引的平坦数组, 编码与解码均不分配内存.
 class ShortcodeAllocator
 {
 public:
+    enum {
+        Alphabet   = 62,                                 //!< 字母表大小
+        ShortLeads = 36,                                 //!< 两字符短码的首字符数量 [a-z0-9]
+        ShortSlots = ShortLeads * Alphabet,              //!< 两字符短码的数量
+        LongSlots  = (Alphabet - ShortLeads) * Alphabet * Alphabet, //!< 三字符扩展短码的数量
+    };
+
+    ShortcodeAllocator() 
+        : m_extended(true)
+        , m_shortHint(0)
+        , m_longHint(0)
+    {}
+
     static ShortcodeAllocator& instance() {
         static ShortcodeAllocator* __imp = nullptr;
         if (__imp == nullptr)
@@ -41,27 +95,96 @@ public:
         return *__imp;
     }
 
+    //! @brief 返回字符在字母表中的序号, 不属于字母表时返回 -1
+    static int charIndex(QChar c) {
+        ushort u = c.unicode();
+        if (u >= 'a' && u <= 'z') return u - 'a';
+        if (u >= '0' && u <= '9') return 26 + (u - '0');
+        if (u >= 'A' && u <= 'Z') return 36 + (u - 'A');
+        return -1;
+    }
+
+    //! @brief 返回字母表中指定序号的字符
+    static QChar indexChar(int index) {
+        Q_ASSERT(index >= 0 && index < Alphabet);
+        if (index < 26) return QChar('a' + index);
+        if (index < 36) return QChar('0' + index - 26);
+        return QChar('A' + index - 36);
+    }
+
+    //! @brief 返回以 lead 开头的短码长度, lead 不属于字母表时返回 0
+    static int codeLength(QChar lead) {
+        int i = charIndex(lead);
+        return i < 0 ? 0 : (i < ShortLeads ? 2 : 3);
+    }
+
+    //! @brief 返回短码对应的槽位, 短码非法时返回 -1
+    static int codeSlot(QStringView code) {
+        if (code.isEmpty() || code.size() != codeLength(code[0]))
+            return -1;
+        int slot = 0;
+        for (QChar c : code) {
+            int i = charIndex(c);
+            if (i < 0)
+                return -1;
+            slot = slot * Alphabet + i;
+        }
+        // 三字符短码的首字符序号从 ShortLeads 开始, 平移后排在两字符短码之后
+        return code.size() == 2 ? slot : ShortSlots + slot - ShortLeads * Alphabet * Alphabet;
+    }
+
+    //! @brief 返回槽位对应的短码
+    static QString slotCode(int slot) {
+        Q_ASSERT(slot >= 0 && slot < ShortSlots + LongSlots);
+        if (slot < ShortSlots) {
+            QChar code[2] = { indexChar(slot / Alphabet), indexChar(slot % Alphabet) };
+            return QString(code, 2);
+        }
+        slot -= ShortSlots;
+        QChar code[3] = { 
+            indexChar(ShortLeads + slot / (Alphabet * Alphabet)),
+            indexChar(slot / Alphabet % Alphabet),
+            indexChar(slot % Alphabet) 
+        };
+        return QString(code, 3);
+    }
+
+    //! @brief 是否允许在两字符短码耗尽后分配三字符扩展短码, 默认允许
+    void setExtendedCodes(bool enable) {
+        m_extended = enable;
+    }
+
+    bool extendedCodes() const {
+        return m_extended;
+    }
+
+    //! @brief 已分配的短码数量
+    int count() const {
+        return m_nameToCode.size();
+    }
+
     //! @brief 为页面名称分配或获取短码
     //! @param pageName 页面名称
-    //! @return 分配的短码 (2字符)
+    //! @return 分配的短码 (2或3字符), 短码空间耗尽时返回空字符串
     QString allocate(const QString& pageName) {
         QString pageName_lower = pageName.toLower();
         
-        // 如果已经分配过, 直接返回
-        if (m_nameToCode.contains(pageName_lower))
-            return m_nameToCode[pageName_lower];
-        
-        // 生成短码: 首字母 + 末字母
-        QString code = generateBaseCode(pageName_lower);
-        
-        // 处理重复: 如果短码已被使用, 尝试生成新的, 如果不能解决冲突, 则崩溃
-        if (m_codeToName.contains(code) && !generateAlternativeCode(code, pageName_lower)) {
-            abort(); // 崩溃, 确保不会发生重复
+        // 如果已经分配过, 增加引用后直接返回
+        auto it = m_nameToCode.constFind(pageName_lower);
+        if (it != m_nameToCode.constEnd()) {
+            ++m_refs[codeSlot(it.value())];
+            return it.value();
         }
-
-        m_nameToCode[pageName_lower] = code;
-        m_codeToName[code] = pageName_lower;
         
+        // 生成短码: 首字母 + 末字母, 冲突时寻找替代短码
+        int slot = baseSlot(pageName_lower);
+        if (slot < 0 || isUsed(slot))
+            slot = alternativeSlot(pageName_lower);
+        if (slot < 0)
+            return {};
+
+        QString code = slotCode(slot);
+        bind(pageName_lower, code, slot);
         return code;
     }
 
@@ -69,123 +192,380 @@ public:
     //! @param pageName 页面名称
     //! @return 页面短码, 不存在时返回空字符串
     QString pageCode(const QString& pageName) const {
-        QString pageName_lower = pageName.toLower();
-        if (m_nameToCode.contains(pageName_lower))
-            return m_nameToCode[pageName_lower];
-        return {};
+        return m_nameToCode.value(pageName.toLower());
     }
 
     //! @brief 根据短码获取页面名称
-    //! @param code 短码
+    //! @param code 短码, 区分大小写; 精确匹配失败时, 两字符短码再按小写匹配一次.
     //! @return 页面名称, 不存在时返回空字符串
-    QString pageName(const QString& code) const {
-        QString codeLower = code.toLower();
-        if (m_codeToName.contains(codeLower))
-            return m_codeToName[codeLower];
+    QString pageName(QStringView code) const {
+        int slot = codeSlot(code);
+        if (slot >= 0 && slot < m_codeToName.size() && !m_codeToName[slot].isNull())
+            return m_codeToName[slot];
+
+        // 兼容手写的大写两字符短码
+        if (code.size() == 2) {
+            QChar lower[2] = { code[0].toLower(), code[1].toLower() };
+            int lowerSlot = codeSlot(QStringView(lower, 2));
+            if (lowerSlot >= 0 && lowerSlot != slot)
+                return m_codeToName.value(lowerSlot);
+        }
         return {};
     }
 
+    //! @brief 释放页面名称的一次引用, 引用计数归零时回收其短码
+    //! @note 同名页面共享同一短码, 每次 allocate() 或 assignShortcode() 都增加一次引用.
+    //! @return 短码是否已被回收
+    bool release(const QString& pageName) {
+        auto it = m_nameToCode.find(pageName.toLower());
+        if (it == m_nameToCode.end())
+            return false;
+        int slot = codeSlot(it.value());
+        if (--m_refs[slot] > 0)
+            return false;
+
+        m_codeToName[slot] = QString();
+        m_nameToCode.erase(it);
+
+        // 回收的槽位可能位于顺序查找的起点之前
+        if (slot < ShortSlots)
+            m_shortHint = qMin(m_shortHint, slotOrder(slot));
+        else
+            m_longHint = qMin(m_longHint, slot - ShortSlots);
+        return true;
+    }
+
     //! @brief 清空所有分配记录
     void clear() {
         m_nameToCode.clear();
         m_codeToName.clear();
+        m_refs.clear();
+        m_shortHint = 0;
+        m_longHint = 0;
     }
 
     //! @brief 强制分配或验证短码
     //! @param pageName 页面名称
-    //! @param customCode 指定的短码(可选), 如果为空则自动分配
-    //! @return 分配的短码, 冲突返回空字符串
+    //! @param customCode 指定的短码(可选), 如果为空则自动分配; 两字符短码不区分大小写.
+    //! @return 分配的短码, 冲突或短码非法时返回空字符串
     QString assignShortcode(const QString& pageName, const QString& customCode = {}) {
         QString pageName_lower = pageName.toLower();
         
-        // 如果已经分配过, 直接返回
-        if (m_nameToCode.contains(pageName_lower))
-            return m_nameToCode[pageName_lower];
-        
-        QString code = customCode.isEmpty() ? QString() : customCode.toLower();
-        
-        // 如果指定了短码，验证冲突
-        if (!code.isEmpty()) {
-            if (m_codeToName.contains(code))
-                return {};  // 冲突
+        // 如果已经分配过, 增加引用后直接返回
+        auto it = m_nameToCode.constFind(pageName_lower);
+        if (it != m_nameToCode.constEnd()) {
+            ++m_refs[codeSlot(it.value())];
+            return it.value();
         }
-        else {
-            // 自动分配
-            code = allocate(pageName);
-            return code;
-        }
-        
-        // 使用指定的短码
-        m_nameToCode[pageName_lower] = code;
-        m_codeToName[code] = pageName_lower;
-        
+
+        // 自动分配
+        if (customCode.isEmpty())
+            return allocate(pageName_lower);
+
+        // 如果指定了短码，验证合法性与冲突
+        QString code = customCode.size() == 2 ? customCode.toLower() : customCode;
+        int slot = codeSlot(code);
+        if (slot < 0 || isUsed(slot))
+            return {};
+
+        bind(pageName_lower, code, slot);
         return code;
     }
 
 private:
-    ShortcodeAllocator() {}
+    //! @brief 槽位是否已被占用
+    bool isUsed(int slot) const {
+        return slot < m_codeToName.size() && !m_codeToName[slot].isNull();
+    }
+
+    //! @brief 登记名称与短码
+    void bind(const QString& name, const QString& code, int slot) {
+        // 扩展短码的表按需增长, 只使用两字符短码时保持 2232 项
+        if (slot >= m_codeToName.size()) {
+            m_codeToName.resize(slot < ShortSlots ? ShortSlots : ShortSlots + LongSlots);
+            m_refs.resize(m_codeToName.size());
+        }
+        m_codeToName[slot] = name;
+        m_refs[slot] = 1;
+        m_nameToCode.insert(name, code);
+    }
 
-    //! @brief 生成基础短码: 首字母 + 末字母
-    QString generateBaseCode(const QString& name) const {
-        if (name.length() < 2)
-            return name.length() == 1 ? name + name : "";
-        return QString(name[0]) + QString(name[name.length() - 1]);
+    //! @brief 基础短码的槽位: 首字母 + 末字母, 字符不可用时返回 -1
+    static int baseSlot(const QString& name) {
+        if (name.isEmpty())
+            return -1;
+        int c1 = charIndex(name[0]);
+        int c2 = charIndex(name[name.size() - 1]);
+        if (c1 < 0 || c1 >= ShortLeads || c2 < 0)
+            return -1;
+        return c1 * Alphabet + c2;
     }
 
-    //! @brief 生成替代短码 (冲突时使用)
-    //! @note 首先尝试名字中的字符组合, 不足时使用任意字符尝试
-    bool generateAlternativeCode(QString& code, const QString& name) const {
+    //! @brief 两字符短码的查找顺序: 首字符依次为 a-z、0-9, 次字符依次为 a-z、A-Z、0-9, 与早期版本相同
+    //! @return 查找顺序中第 order 个短码的槽位
+    static int orderSlot(int order) {
+        int n = order % Alphabet;
+        return order - n + (n < 26 ? n : (n < 52 ? n + 10 : n - 26));
+    }
+
+    //! @brief orderSlot() 的逆映射
+    static int slotOrder(int slot) {
+        int i = slot % Alphabet;
+        return slot - i + (i < 26 ? i : (i < 36 ? i + 26 : i - 10));
+    }
 
+    //! @brief 寻找替代短码的槽位 (冲突时使用), 短码空间耗尽时返回 -1
+    //! @note 两字符短码的分配顺序与早期版本相同, 已保存的短码路径在相同的安装顺序下保持不变: 
+    //!       首先尝试名字中的字符组合(单字符名称再尝试以其开头的所有短码), 然后跳过以名称首字符开头的短码顺序查找.
+    //!       顺序查找从第一个空闲位置起进行, 起点只在 release() 回收槽位时回退.
+    int alternativeSlot(const QString& name) {
         // 第一阶段：从 name 中提取组合
-        if (!name.isEmpty()) {
+        int c1 = name.isEmpty() ? -1 : charIndex(name[0]);
+        if (c1 >= 0 && c1 < ShortLeads) {
             for (int i = 1; i < name.size(); ++i) {
-                if (!m_codeToName.contains(QString(name[0]) + name[i])) {
-                    code = QString(name[0]) + name[i];
-                    return true;
-                }
+                int c2 = charIndex(name[i]);
+                if (c2 >= 0 && !isUsed(c1 * Alphabet + c2))
+                    return c1 * Alphabet + c2;
+            }
+            if (name.size() == 1) {
+                for (int order = c1 * Alphabet; order < (c1 + 1) * Alphabet; ++order)
+                    if (!isUsed(orderSlot(order)))
+                        return orderSlot(order);
             }
         }
 
-        const QString chars =
-            "abcdefghijklmnopqrstuvwxyz"
-            "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-            "0123456789";
-
-        auto test = [&](QString c1) -> bool {
-            for (QChar c2 : chars) {
-                if (!m_codeToName.contains(c1 + c2)) {
-                    code = c1 + c2;
-                    return true;
-                }
-            }
-            return false;
-        };
+        // 第二阶段：顺序查找空闲的两字符短码, 跳过以名称首字符开头的短码
+        while (m_shortHint < ShortSlots && isUsed(orderSlot(m_shortHint)))
+            ++m_shortHint;
+        for (int order = m_shortHint; order < ShortSlots; ++order) {
+            int slot = orderSlot(order);
+            if (slot / Alphabet != c1 && !isUsed(slot))
+                return slot;
+        }
 
-        // 如果 name 只有一个字符
-        if (name.size() == 1) {
-            if (test(name[0])) 
-                return true;
+        // 第三阶段：三字符扩展短码
+        if (m_extended) {
+            for (; m_longHint < LongSlots; ++m_longHint)
+                if (!isUsed(ShortSlots + m_longHint))
+                    return ShortSlots + m_longHint;
         }
+        return -1;
+    }
 
-        // 第二阶段：遍历所有 chars 两字符组合
-        for (QChar c1 : chars) {
-            if (c1 != name[0]) {
-                if (test(c1))
-                    return true;
-            }
+private:
+    bool                    m_extended;     //!< 是否允许三字符扩展短码
+    int                     m_shortHint;    //!< 两字符短码的顺序查找起点, 按查找顺序计, 参见 orderSlot()
+    int                     m_longHint;     //!< 扩展短码的顺序查找起点
+    QHash<QString, QString> m_nameToCode;   //!< pageName -> shortcode
+    QVector<QString>        m_codeToName;   //!< slot -> pageName, 空字符串表示空闲
+    QVector<int>            m_refs;         //!< slot -> 引用计数
+};
+
+//! @brief 路由标识, 将短码路径打包为两个 64 位整数的值类型
+//! @note 短码路径的每个字符按 ShortcodeAllocator 的字母表编码为 6 位符号(序号 + 1, 0 表示结束),
+//!       每个整数容纳 10 个符号, 因此最多表示 20 个字符的短码路径(例如 10 级两字符短码).
+//!       比较、哈希均为常数时间, 与短码路径之间的相互转换不分配内存.
+class RouteId
+{
+public:
+    enum {
+        SymbolsPerWord = 10,                //!< 每个整数容纳的符号数
+        MaxLength      = 2 * SymbolsPerWord,//!< 短码路径的最大长度
+    };
+
+    RouteId() : m_hi(0), m_lo(0) {}
+
+    //! @brief 从短码路径构造, 路径非法或超出 MaxLength 时返回空路由
+    static RouteId fromShortcodePath(QStringView shortcodePath) {
+        RouteId id;
+        if (shortcodePath.size() > MaxLength)
+            return {};
+        for (int i = 0; i < shortcodePath.size(); ++i) {
+            int symbol = ShortcodeAllocator::charIndex(shortcodePath[i]);
+            if (symbol < 0)
+                return {};
+            id.word(i) |= quint64(symbol + 1) << shift(i);
         }
+        return id;
+    }
 
-        return false;
+    //! @brief 是否为空路由
+    bool isNull() const {
+        return m_hi == 0;
+    }
+
+    //! @brief 短码路径的长度
+    int length() const {
+        int n = 0;
+        while (n < MaxLength && symbol(n) != 0)
+            ++n;
+        return n;
+    }
+
+    //! @brief 将短码路径写入 out, out 至少要能容纳 MaxLength 个字符
+    //! @return 写入的字符数
+    int toChars(QChar* out) const {
+        int n = 0;
+        for (int s; n < MaxLength && (s = symbol(n)) != 0; ++n)
+            out[n] = ShortcodeAllocator::indexChar(s - 1);
+        return n;
+    }
+
+    //! @brief 返回短码路径
+    QString toShortcodePath() const {
+        QChar buffer[MaxLength];
+        return QString(buffer, toChars(buffer));
+    }
+
+    //! @brief 批量转换短码路径, 非法的路径对应空路由
+    static QVector<RouteId> fromShortcodePaths(const QStringList& shortcodePaths) {
+        QVector<RouteId> result;
+        result.reserve(shortcodePaths.size());
+        for (const auto& path : shortcodePaths)
+            result.append(fromShortcodePath(path));
+        return result;
+    }
+
+    //! @brief 批量转换为短码路径
+    static QStringList toShortcodePaths(const QVector<RouteId>& ids) {
+        QStringList result;
+        result.reserve(ids.size());
+        for (const auto& id : ids)
+            result.append(id.toShortcodePath());
+        return result;
+    }
+
+    quint64 hi() const { return m_hi; }
+    quint64 lo() const { return m_lo; }
+
+    //! @note 按短码路径的字典序比较, 较短的前缀排在前面
+    friend bool operator<(const RouteId& a, const RouteId& b) {
+        return a.m_hi != b.m_hi ? a.m_hi < b.m_hi : a.m_lo < b.m_lo;
+    }
+    friend bool operator==(const RouteId& a, const RouteId& b) {
+        return a.m_hi == b.m_hi && a.m_lo == b.m_lo;
+    }
+    friend bool operator!=(const RouteId& a, const RouteId& b) {
+        return !(a == b);
+    }
+
+private:
+    static int shift(int i) {
+        return (SymbolsPerWord - 1 - i % SymbolsPerWord) * 6;
+    }
+
+    quint64& word(int i) {
+        return i < SymbolsPerWord ? m_hi : m_lo;
+    }
+
+    int symbol(int i) const {
+        return int(((i < SymbolsPerWord ? m_hi : m_lo) >> shift(i)) & 0x3f);
+    }
+
+private:
+    quint64 m_hi;   //!< 第 0~9 个符号
+    quint64 m_lo;   //!< 第 10~19 个符号
+};
+
+inline uint qHash(const RouteId& id, uint seed = 0) {
+    return qHash(quint64(id.hi() ^ (id.lo() * Q_UINT64_C(0x9E3779B97F4A7C15))), seed);
+}
+
+Q_DECLARE_TYPEINFO(RouteId, Q_PRIMITIVE_TYPE);
+
+//! @brief 共享的只读页面参数
+//! @note 将较大的数据(例如解码后的图片、结果表)包装为引用计数的只读负载放入 QVariantMap,
+//!       在页面之间、历史快照以及 m_lastParams 之间传递时只复制指针, 不会深拷贝数据.
+//! @code
+//!   params["table"] = PageParam::wrap(std::move(table));
+//!   ...
+//!   if (auto table = param<ResultTable>("table")) // 在 AbstractPage 中读取, 不经过 QVariant 的类型转换
+//!       ...
+//! @endcode
+class PageParam
+{
+public:
+    PageParam() {}
+
+    //! @brief 构造持有 value 的参数, value 被移动或复制一次后不再改变
+    template<class T>
+    static PageParam make(T&& value) {
+        PageParam param;
+        param.m_payload.reset(new Holder<typename std::decay<T>::type>(std::forward<T>(value)));
+        return param;
+    }
+
+    //! @brief 构造持有 value 的参数并包装为 QVariant, 便于直接放入 QVariantMap
+    template<class T>
+    static QVariant wrap(T&& value) {
+        return QVariant::fromValue(make(std::forward<T>(value)));
+    }
+
+    //! @brief 返回负载的指针, 类型不匹配或参数为空时返回空指针
+    template<class T>
+    const T* get() const {
+        if (m_payload.isNull() || m_payload->type() != typeid(T))
+            return nullptr;
+        return &static_cast<const Holder<T>*>(m_payload.data())->value;
+    }
+
+    //! @brief 返回 variant 中 PageParam 负载的指针, 不复制 variant, 也不经过 QVariant 的类型转换
+    template<class T>
+    static const T* peek(const QVariant& variant) {
+        if (variant.userType() != qMetaTypeId<PageParam>())
+            return nullptr;
+        return static_cast<const PageParam*>(variant.constData())->get<T>();
+    }
+
+    bool isNull() const {
+        return m_payload.isNull();
+    }
+
+    //! @note 只比较是否共享同一个负载
+    bool operator==(const PageParam& other) const {
+        return m_payload == other.m_payload;
     }
 
 private:
-    QMap<QString, QString> m_nameToCode;  //!< pageName -> shortcode
-    QMap<QString, QString> m_codeToName;  //!< shortcode -> pageName
+    struct Payload
+    {
+        virtual ~Payload() {}
+        virtual const std::type_info& type() const = 0;
+    };
+
+    template<class T>
+    struct Holder : Payload
+    {
+        template<class U>
+        explicit Holder(U&& v) : value(std::forward<U>(v)) {}
+        const std::type_info& type() const override { return typeid(T); }
+        const T value;
+    };
+
+    QSharedPointer<const Payload> m_payload;
 };
 
+Q_DECLARE_METATYPE(PageParam)
+
+//! @brief 页面参数的声明, 用于将深度链接的查询参数转换为指定的类型
+//! @see PagesContainer::setParamSchema(), PagesManager::parseLink()
+struct PageParamSpec
+{
+    QString key;                        //!< 参数名
+    int     type = QMetaType::QString;  //!< 参数类型(QMetaType 类型编号)
+    bool    required = false;           //!< 是否必须提供
+};
+
+//! @brief 页面接受的全部参数, 声明为空的页面接受任意参数(均为字符串)
+typedef QVector<PageParamSpec> PageParamSchema;
+
 // 前置声明
 class PagesManager;
 class PagesContainer;
+class AbstractPage;
+
+//! @brief 页面工厂, 用于延迟构造页面实例
+typedef std::function<AbstractPage*()> PageFactory;
 
 //! @brief 抽象页面
 //! @note 所有需要被纳入管理的页面必须继承此类。
@@ -197,8 +577,19 @@ class AbstractPage : public QWidget
     friend class PagesContainer;
     friend class PagesManager;
 public:
+    //! @brief 页面生命周期状态
+    enum PageState
+    {
+        Constructed,    //!< 已构造, 尚未 pageLazyInit()
+        Initialized,    //!< 已 pageLazyInit(), 尚未进入过当前路径
+        Active,         //!< 位于当前路径上
+        Suspended,      //!< 曾位于当前路径上, 现已离开, 参见 pageSuspend()
+        Evicted,        //!< 已因超出内存预算被回收, 实例即将销毁
+    };
+    Q_ENUM(PageState)
+
     AbstractPage(PagesContainer* container = nullptr);
-    virtual ~AbstractPage() {}
+    virtual ~AbstractPage();
 
     //! @brief 返回页面名称
     //! @note 页面名称在同一层级中应该唯一, 且不能为空.
@@ -207,14 +598,32 @@ public:
     //! @brief 返回页面的唯一短码
     QString code() const { return m_shortcode; }
 
+    //! @brief 返回页面的生命周期状态
+    PageState pageState() const { return m_state; }
+
+    //! @brief 返回页面池中的实例当前绑定的数据键, 不属于页面池时为空
+    //! @see PagesContainer::installPagePool()
+    QString poolKey() const { return m_poolKey; }
+
     //! @brief 返回页面路径
     //! @note 大小写不敏感, 页面路径应该唯一, 且不能为空.
+    //! @note 路径在首次访问时计算并缓存, 页面在树中的位置改变时失效, 返回的是共享的字符串.
     QString pagePath() const {
-        QStringList hops(name());
-        auto p = this;
-        while (p = p->parentPage())
-            hops.push_front(p->name());
-        return "/" + hops.join('/');
+        if (m_pathCache.isNull()) {
+            auto p = parentPage();
+            m_pathCache = (p ? p->pagePath() : QString()) + "/" + name();
+        }
+        return m_pathCache;
+    }
+
+    //! @brief 返回页面的短码路径
+    //! @note 与 pagePath() 一样被缓存, 格式参见 PagesManager::toShortcodePath().
+    QString shortcodePath() const {
+        if (m_codePathCache.isNull()) {
+            auto p = parentPage();
+            m_codePathCache = (p ? p->shortcodePath() : QString()) + code();
+        }
+        return m_codePathCache;
     }
 
     //! @brief 返回父容器
@@ -228,11 +637,28 @@ public:
     QVariant&    lastParam(const QString& key) { return m_lastParams[key]; }
     QVariantMap& lastParams() { return m_lastParams; }
 
+    //! @brief 返回 m_lastParams 中以 PageParam 传递的参数
+    //! @return 负载的指针, 键不存在、值不是 PageParam 或类型不匹配时返回空指针
+    //! @note 直接读取共享的负载, 不复制也不经过 QVariant 的类型转换.
+    template<class T>
+    const T* param(const QString& key) const {
+        auto it = m_lastParams.constFind(key);
+        return it == m_lastParams.constEnd() ? nullptr : PageParam::peek<T>(it.value());
+    }
+
     //! @brief 页面惰性初始化事件
     //! @note  pageLazyInit() 事件中页面期望: 自己真正被访问前才被初始化。
     //! 会在pageEnter(), pageInvoke(), pageRaises()之前被调用, 并保证每个页面实例仅调用一次.
     virtual void pageLazyInit() {};
 
+    //! @brief 页面挂起事件 (页面离开当前路径时, 被PagesManager调用)
+    //! @note  pageSuspend() 事件中页面期望: 停止定时器、动画以及实时的模型更新等对不可见页面无意义的工作.
+    virtual void pageSuspend() {};
+
+    //! @brief 页面恢复事件 (页面进入当前路径时, 被PagesManager调用)
+    //! @note  pageResume() 事件中页面期望: 恢复 pageSuspend() 中停止的工作, 页面首次进入当前路径时也会被调用.
+    virtual void pageResume() {};
+
     //! @brief 页面提升事件 (需要时, 被PagesManager调用)
     //! @note  pageRaises() 事件中页面期望: 将自身提升到最上层, 确保自己被激活时, 界面上显示的是自己。
     virtual void pageRaises();
@@ -253,6 +679,109 @@ public:
     //!          2. pageEnter() 只有在目标页面被激活 且 params 参数有效, 才会被调用.
     virtual void pageEnter(QString lastPath, QVariantMap& params) {};
 
+    //! @brief 设置页面是否使用异步准备
+    //! @note 启用后, 页面首次被 pageSwitch() 访问时, 将在线程池中调用 pagePrepare(), 完成后在GUI线程中调用 pagePrepared().
+    void setAsyncPrepare(bool enable) { m_asyncPrepare = enable; }
+
+    bool asyncPrepare() const { return m_asyncPrepare; }
+
+    //! @brief 主题通知的投递条件, 参见 subscribe()
+    enum NotifyFlag
+    {
+        NotifyActive        = 0x0,  //!< 只在页面位于当前路径上(Active)时投递
+        NotifyInactive      = 0x1,  //!< 页面已初始化但不在当前路径上(Initialized, Suspended)时也投递
+        NotifyUninitialized = 0x2,  //!< 页面尚未 pageLazyInit() (Constructed)时也投递
+    };
+    Q_DECLARE_FLAGS(NotifyFlags, NotifyFlag)
+
+    //! @brief 订阅主题, 通过 PagesManager::publish() 发布的事件将触发 pageNotify()
+    //! @param flags 投递条件, 默认只在页面处于当前路径上时投递
+    //! @note 重复订阅同一主题将更新投递条件, 页面销毁或被回收时自动退订.
+    void subscribe(const QString& topic, NotifyFlags flags = NotifyActive);
+
+    //! @brief 退订主题
+    void unsubscribe(const QString& topic);
+
+    //! @brief 主题通知事件 (订阅的主题发布事件时, 被PagesManager调用)
+    //! @param topic 主题名称
+    //! @param params 事件参数
+    //! @note  pageNotify() 事件中页面期望: 响应设备列表变化等广播事件.
+    virtual void pageNotify(const QString& topic, const QVariantMap& params) {};
+
+    //! @brief 设置是否合并积压的异步调用
+    //! @note 启用后, PagesManager::pageInvokeAsync() 发往本页面的消息来不及处理时, 相同合并键的消息只保留最新的一条.
+    void setCoalesceInvokes(bool enable) { m_coalesceInvokes = enable; }
+
+    bool coalesceInvokes() const { return m_coalesceInvokes; }
+
+    //! @brief 设置页面离开屏幕时是否抓取快照, 默认启用
+    //! @note 仅在 PagesManager::setSnapshotCache() 启用时生效, 内容随时间变化(例如动画, 视频)的页面应当关闭.
+    void setSnapshotEnabled(bool enable);
+
+    bool snapshotEnabled() const { return m_snapshotEnabled; }
+
+    //! @brief 页面是否在屏幕上, 参见 PagesManager::isOnScreen()
+    bool isOnScreen() const;
+
+    //! @brief 经过可见性闸门执行更新
+    //! @param key 合并键, 页面不在屏幕上时相同合并键的更新只保留最新的一条; 为空时不合并
+    //! @param update 更新操作, 例如刷新模型、使布局失效
+    //! @return 是否已立即执行
+    //! @note 页面在屏幕上时立即执行; 否则推迟到页面再次显示时, 按首次推迟的顺序一次性执行.
+    //!       页面被回收或销毁时, 尚未执行的更新被丢弃, 页面应在重新构造时从数据源完整地刷新;
+    //!       页面池实例(及其子页面)重新绑定数据键时同样丢弃, 这些更新属于旧的数据键.
+    bool deferUpdate(const QString& key, std::function<void()> update);
+
+    //! @brief 立即执行所有被推迟的更新
+    void flushUpdates();
+
+    //! @brief 被推迟且尚未执行的更新数
+    int pendingUpdates() const { return m_deferredUpdates.size(); }
+
+    //! @brief 声明页面接受的参数, 参见 PagesContainer::setParamSchema()
+    //! @note 页面必须已经安装在容器中; 页面池中的实例为整个路由声明.
+    void setParamSchema(PageParamSchema schema);
+
+    //! @brief 丢弃页面的快照
+    //! @note 页面数据在离开屏幕后发生变化, 快照不再代表页面的外观时调用.
+    void invalidateSnapshot();
+
+    //! @brief 页面数据是否已经准备完成
+    //! @note 未启用异步准备的页面始终返回 true.
+    bool isPrepared() const { return !m_asyncPrepare || m_prepared; }
+
+    //! @brief 页面异步准备事件 (在线程池中被调用)
+    //! @param params 页面参数, 即准备开始时的 m_lastParams
+    //! @param isCanceled 返回准备是否已被取消, 耗时的准备过程中应定期检查, 被取消时尽早返回.
+    //! @return 页面数据, 将传递给 pagePrepared()
+    //! @note  pagePrepare() 事件运行在非GUI线程, 页面期望: 加载数据库、设备目录等耗时数据, 且不得访问任何界面元素.
+    virtual QVariant pagePrepare(QVariantMap params, const std::function<bool()>& isCanceled) { return {}; }
+
+    //! @brief 页面等待事件 (异步准备开始时, 被PagesManager调用)
+    //! @note  pagePending() 事件中页面期望: 显示加载中的占位状态, 页面随后会立即被提升显示.
+    virtual void pagePending() {};
+
+    //! @brief 页面准备完成事件 (在GUI线程中被调用)
+    //! @param data pagePrepare() 的返回值
+    //! @note  pagePrepared() 事件中页面期望: 将数据应用到界面上, 替换掉占位状态.
+    virtual void pagePrepared(const QVariant& data) {};
+
+    //! @brief 子页面切换事件 (差量切换模式下, 被PagesManager调用)
+    //! @param oldPath 切换前的当前页面路径
+    //! @param newPath 切换后的当前页面路径
+    //! @note  PagesManager::DifferentialSwitch 模式下, 新旧路径的公共前缀上的页面不再触发 pageShow(), pageRaises(),
+    //!        需要在子页面变化时刷新自身的页面可以重写此事件.
+    virtual void pageDescendantChanged(QString oldPath, QString newPath) {};
+
+    //! @brief 页面回收事件 (页面因超出内存预算被销毁之前, 被PagesManager调用)
+    //! @note  pageEvict() 事件中页面期望: 将需要保留的额外状态写入 m_lastParams, 
+    //!        m_lastParams 会被保留, 页面重新构造后在 pageLazyInit() 之前恢复.
+    //! @note  只有通过 PageFactory 安装的页面才会被回收, 其已构造的子、孙页面随之回收, 并且先于它触发此事件.
+    virtual void pageEvict() {};
+
+    //! @brief 返回页面当前占用内存的估计值(字节), 用于 PagesManager::setPageBudget() 的字节预算.
+    virtual qint64 pageMemoryUsage() const { return 0; }
+
     //! @brief 页面调用事件
     //! @param callerPath 调用者的路径
     //! @param params 页面参数
@@ -284,8 +813,13 @@ public:
     //! @note 页面只能安装在页面容器中, 因此如果需要多级页面的话, 就需要在页面中挂载存放子页面的页面容器。
     virtual void installContainer(PagesContainer* container);
 
+    //! @brief 卸载页面容器
+    //! @note 容器中的所有页面一并卸载, 参见 PagesContainer::uninstallPages(); 容器实例延迟销毁.
+    virtual void uninstallContainer(PagesContainer* container);
+
     //! @brief 返回自此页面以下的所有子、孙页面。
-    const QMap<QString, AbstractPage*> subpages() const;
+    //! @param create 是否构造尚未构造的延迟页面, 为 false 时这些页面对应的值为空指针.
+    const QMap<QString, AbstractPage*> subpages(bool create = true) const;
 
     //! @brief 返回此页面中第一个匹配 name 的子页面。
     AbstractPage* subpage(QString name) const;
@@ -295,13 +829,31 @@ public:
     AbstractPage* parentPage() const;
 
 protected:
+    //! @brief 使此页面及其所有子、孙页面的路径缓存失效
+    void invalidatePath();
+
+protected:
+    mutable QString m_pathCache;        //!< pagePath() 的缓存
+    mutable QString m_codePathCache;    //!< shortcodePath() 的缓存
     QString m_name;                     //!< 页面名称
     QString m_shortcode;                //!< 页面短码
+    QString m_poolKey;                  //!< 页面池中绑定的数据键
     QVariantMap m_lastParams;           //!< 最近的页面入参
+    PageState m_state = Constructed;    //!< 生命周期状态
+    quint64 m_lastUsed = 0;             //!< 最近一次被访问的时刻(PagesManager 内部计数)
+    bool m_asyncPrepare = false;        //!< 是否使用异步准备
+    bool m_prepared = false;            //!< 异步准备是否已完成
+    bool m_coalesceInvokes = false;     //!< 是否合并积压的异步调用
+    bool m_snapshotEnabled = true;      //!< 离开屏幕时是否抓取快照
+    QVector<quint32> m_topics;          //!< 已订阅的主题编号
+    QVector<QPair<QString, std::function<void()>>> m_deferredUpdates; //!< 被推迟的更新: 合并键, 操作
+    QFutureInterface<QVariant> m_prepare; //!< 进行中的异步准备
     PagesContainer* m_parent;           //!< 父容器
     QSet<PagesContainer*> m_containers; //!< 已安装的容器实例
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(AbstractPage::NotifyFlags)
+
 //! @brief 页面容器(通常在UI设计师中从QStackedWidget提升过来)
 //! @note 页面容器可以理解为页面路径中的分隔符 (/), 页面必须安装在页面容器中, 最顶端的页面容器称为 root.
 class PagesContainer : public QStackedWidget
@@ -315,7 +867,7 @@ public:
         , m_parentPage(nullptr)
     {}
 
-    virtual ~PagesContainer() {}
+    virtual ~PagesContainer();
 
     //! @brief 安装页面到页面容器中, 并指定页面的名称
     //! @param name 页面名称, 在同一层级中应该唯一, 且不能为空.
@@ -326,50 +878,147 @@ public:
 
     //! @brief 安装页面到页面容器中, 并指定页面的名称和短码
     //! @param name 页面名称, 在同一层级中应该唯一, 且不能为空.
-    //! @param shortcode 页面短码(2字符), 如果为空则自动分配
+    //! @param shortcode 页面短码(2或3字符), 如果为空则自动分配, 参见 ShortcodeAllocator
     //! @param page 页面实例
     //! @note 如果短码冲突，将以致命错误结束
-    virtual void installPageWithCode(QString name, QString shortcode, AbstractPage* page) {
-        name = name.toLower();
-        Q_ASSERT(!m_names.contains(name));
-        
-        // 分配或验证短码
-        ShortcodeAllocator& allocator = ShortcodeAllocator::instance();
-        QString assignedCode = allocator.assignShortcode(name, shortcode);
-        
-        if (assignedCode.isEmpty()) {
-            Q_ASSERT_X(false, "PagesContainer::installPageWithCode", 
-                       QString("Shortcode collision: %1").arg(shortcode).toStdString().c_str());
-            return;
-        }
-        
-        m_names[name] = QStackedWidget::addWidget(page);
-        page->m_name = name;
-        page->m_shortcode = assignedCode;
-        page->m_parent = this;
+    virtual void installPageWithCode(QString name, QString shortcode, AbstractPage* page);
+
+    //! @brief 安装延迟构造的页面到页面容器中
+    //! @param name 页面名称, 在同一层级中应该唯一, 且不能为空.
+    //! @param factory 页面工厂
+    //! @note 立即保留页面的名称、短码以及在 QStackedWidget 中的位置, 
+    //!       页面实例直到首次被 pageSwitch(), page(), pageInvoke() 访问时才由 factory 构造.
+    virtual void installPage(QString name, PageFactory factory) {
+        installPageWithCode(name, {}, std::move(factory));
+    }
+
+    //! @brief 安装延迟构造的页面到页面容器中, 并指定页面的名称和短码
+    //! @see installPage(QString, PageFactory)
+    virtual void installPageWithCode(QString name, QString shortcode, PageFactory factory);
+
+    //! @brief 安装页面池, 为形如 name:key 的参数化路由提供页面实例
+    //! @param name 路由名称, 页面以 name:key 访问, 例如 /view/device:a, key 为数据键, 不能为空或包含 /
+    //! @param factory 页面工厂
+    //! @param capacity 池中实例数的上限
+    //! @note 访问新的数据键时构造新实例, 池满时将最久未使用且不在当前路径上的实例重新绑定到该数据键;
+    //!       所有实例都在当前路径上时临时超出容量, 超出的实例在导航结束、离开当前路径后被销毁.
+    //!       每个数据键的 m_lastParams(以及其子、孙页面的)保存在实例之外, 实例重新绑定时换出旧键、换入新键的参数,
+    //!       因此页面应当是无状态的, 在 pageShow() 中根据 m_lastParams 完整地刷新界面.
+    //! @note 池中的实例不出现在 begin()/end(), pages() 以及 PagesManager::visitPages() 中, 也没有唯一的短码路径.
+    virtual void installPagePool(QString name, PageFactory factory, int capacity = 4);
+
+    //! @brief 声明页面接受的参数
+    //! @param name 页面名称, 或者页面池的路由名称; 延迟页面在构造之前即可声明
+    //! @param schema 参数声明, 深度链接中的查询参数将按声明转换类型并校验, 参见 PagesManager::parseLink()
+    void setParamSchema(QString name, PageParamSchema schema) {
+        Q_ASSERT_X(schema.size() <= 64, "PagesContainer::setParamSchema", "too many parameters");
+        m_schemas[name.toLower()] = std::move(schema);
+    }
+
+    //! @brief 返回页面的参数声明, 未声明时返回空指针
+    //! @param name 页面名称, 页面池中的页面(name:key)返回其路由的声明
+    const PageParamSchema* paramSchema(const QString& name) const {
+        if (m_schemas.isEmpty())
+            return nullptr;
+        auto it = m_schemas.constFind(name);
+        if (it == m_schemas.constEnd() && const_cast<PagesContainer*>(this)->poolOf(name))
+            it = m_schemas.constFind(name.left(name.indexOf(':')));
+        return it == m_schemas.constEnd() ? nullptr : &it.value();
+    }
+
+    //! @brief 从页面容器中卸载页面
+    //! @param name 页面名称, 或者页面池的路由名称
+    //! @see uninstallPages()
+    void uninstallPage(QString name) {
+        uninstallPages(QStringList{ std::move(name) });
     }
 
+    //! @brief 批量卸载页面
+    //! @param names 页面名称, 或者页面池的路由名称, 不存在的名称将被忽略
+    //! @note 页面连同其子、孙页面一起从路径索引、前进/后退历史以及各项缓存中移除, 短码被释放, 页面实例延迟销毁.
+    //!       整批页面只重排一次容器的索引, 只重建一次历史. 
+    //! @note 卸载当前路径上的页面时, 路径上处于激活状态的页面先被挂起(pageSuspend()), 之后当前页面为空, 应随后切换到其他页面.
+    //!       被卸载的页面仍有后台准备任务时, 任务被取消, 并在销毁页面之前等待其结束.
+    virtual void uninstallPages(QStringList names);
+
     //! @brief 获取指定名称的页面实例
     //! @param name 页面名称
-    //! @note 指定的页面不存在将返回空指针.
+    //! @note 指定的页面不存在将返回空指针, 尚未构造的延迟页面将在此时构造, 
+    //!       页面池的路由(name:key)将在此时绑定一个池中的实例.
     AbstractPage* page(QString name) const {
         name = name.toLower();
-        if (m_names.contains(name))
-            return static_cast<AbstractPage*>(QStackedWidget::widget(m_names[name]));
+        auto it = m_names.constFind(name);
+        if (it != m_names.constEnd())
+            return const_cast<PagesContainer*>(this)->pageAt(it.value());
+        if (!m_pools.isEmpty())
+            return const_cast<PagesContainer*>(this)->poolPage(name);
         return {};
     }
 
+    //! @brief 页面是否已经构造
+    //! @note 对于通过 installPage(QString, PageFactory) 安装且尚未被访问的页面返回 false,
+    //!       对于页面池的路由, 当前有实例绑定到该数据键时返回 true.
+    bool isPageCreated(QString name) const {
+        name = name.toLower();
+        auto it = m_names.constFind(name);
+        if (it == m_names.constEnd())
+            return pooledPage(name) != nullptr;
+        return qobject_cast<AbstractPage*>(QStackedWidget::widget(it.value()));
+    }
+
+    //! @brief 设置容器的短码作用域
+    //! @param scope 局部短码分配器, 为空时使用全局的 ShortcodeAllocator::instance()
+    //! @note 必须在安装页面之前设置. 局部作用域中的短码只需在作用域内唯一, 
+    //!       挂载在同一页面下的多个容器如果都使用局部作用域, 应共享同一个分配器实例, 
+    //!       否则同一短码可能同时指向兄弟容器中的不同页面, 使短码路径无法解码.
+    void setShortcodeScope(QSharedPointer<ShortcodeAllocator> scope) {
+        Q_ASSERT_X(m_names.isEmpty(), "PagesContainer::setShortcodeScope", "pages already installed");
+        m_scope = std::move(scope);
+    }
+
+    //! @brief 获取容器使用的短码分配器
+    ShortcodeAllocator& shortcodes() const {
+        return m_scope ? *m_scope : ShortcodeAllocator::instance();
+    }
+
     //! @brief 获取父页面实例
     //! @note 页面容器可能会挂载在其他页面中, 以此形成多级页面, 没有父页面将返回空指针, 此时表示页面容器是 root.
     AbstractPage* parentPage() const {
         return m_parentPage;
     }
 
+    //! @brief 容器中页面的迭代器
+    //! @note 按名称顺序遍历, 不构造延迟页面, 也不分配内存; 解引用得到页面实例, 尚未构造的延迟页面为空指针.
+    class PageIterator
+    {
+    public:
+        PageIterator(const PagesContainer* container, QMap<QString, int>::const_iterator it)
+            : m_container(container), m_it(it) {}
+
+        const QString& name() const { return m_it.key(); }
+        AbstractPage* page() const { return qobject_cast<AbstractPage*>(m_container->widget(m_it.value())); }
+        AbstractPage* operator*() const { return page(); }
+        PageIterator& operator++() { ++m_it; return *this; }
+        bool operator==(const PageIterator& other) const { return m_it == other.m_it; }
+        bool operator!=(const PageIterator& other) const { return m_it != other.m_it; }
+
+    private:
+        const PagesContainer* m_container;
+        QMap<QString, int>::const_iterator m_it;
+    };
+
+    PageIterator begin() const { return PageIterator(this, m_names.constBegin()); }
+    PageIterator end() const { return PageIterator(this, m_names.constEnd()); }
+
     //! @brief 获取容器中所有页面实例, 不包括下层页面.
-    const QMap<QString, AbstractPage*> pages() const {
+    //! @param create 是否构造尚未构造的延迟页面, 为 false 时这些页面对应的值为空指针.
+    //! @note 返回新构造的 QMap, 只需遍历时使用 begin(), end() 或 PagesManager::visitPages().
+    const QMap<QString, AbstractPage*> pages(bool create = true) const {
         QMap<QString, AbstractPage*> result;
         for (auto it = m_names.constBegin(); it != m_names.constEnd(); ++it)
-            result[it.key()] = static_cast<AbstractPage*>(QStackedWidget::widget(it.value()));
+            result[it.key()] = create
+                ? const_cast<PagesContainer*>(this)->pageAt(it.value())
+                : qobject_cast<AbstractPage*>(QStackedWidget::widget(it.value()));
         return result;
     }
 
@@ -377,92 +1026,886 @@ public:
     //! @param name 页面名称
     void setCurrentPage(QString name) {
         name = name.toLower();
+        if (auto page = pooledPage(name)) {
+            QStackedWidget::setCurrentWidget(page);
+            return;
+        }
         Q_ASSERT(m_names.contains(name));
         QStackedWidget::setCurrentIndex(m_names[name]);
     }
 
 protected:
-    void showEvent(QShowEvent* e) {
-        if (auto page = static_cast<AbstractPage*>(QStackedWidget::widget(currentIndex()))) {
-            if (!page->property("initialized").toBool()) {
-                page->pageLazyInit();
-                page->setProperty("initialized", true);
-            }
-        }
-        QStackedWidget::showEvent(e);
+    //! @brief 页面池, 参见 installPagePool()
+    struct PagePool
+    {
+        PageFactory            factory;
+        QString                code;            //!< 路由名称的短码
+        int                    capacity = 0;    //!< 实例数的上限
+        QVector<AbstractPage*> members;         //!< 已构造的实例, 各自绑定一个数据键
+    };
+
+    //! @brief 返回 name:key 形式的名称所属的页面池, 不是页面池的路由时返回空指针
+    PagePool* poolOf(const QString& name) {
+        if (m_pools.isEmpty())
+            return nullptr;
+        int sep = name.indexOf(':');
+        if (sep <= 0 || sep == name.size() - 1 || name.contains('/'))
+            return nullptr;
+        auto it = m_pools.find(name.left(sep));
+        return it == m_pools.end() ? nullptr : &it.value();
+    }
+
+    //! @brief 返回页面池中当前绑定到 name 的实例, 不构造也不重新绑定实例
+    AbstractPage* pooledPage(const QString& name) const {
+        if (auto pool = const_cast<PagesContainer*>(this)->poolOf(name))
+            for (auto page : pool->members)
+                if (page->m_name == name)
+                    return page;
+        return nullptr;
+    }
+
+    //! @brief 返回绑定到 name 的池中实例, 没有时由页面管理器绑定一个
+    AbstractPage* poolPage(const QString& name);
+
+    //! @brief 依次访问容器中所有已构造的页面, 包括页面池中的实例
+    template<class Fn>
+    void visitCreated(Fn fn) const {
+        for (auto it = begin(); it != end(); ++it)
+            if (auto page = it.page())
+                fn(page);
+        for (const auto& pool : m_pools)
+            for (auto page : pool.members)
+                fn(page);
     }
 
+
+    void showEvent(QShowEvent* e);
+
+    //! @brief 返回指定位置的页面实例, 尚未构造的延迟页面将在此时构造
+    AbstractPage* pageAt(int index);
+
+    //! @brief 销毁延迟页面的实例并换回占位控件, 下次访问时由工厂重新构造
+    void releasePage(AbstractPage* page);
+
+    //! @brief 将 index 处的控件替换为 widget, 并保持当前页不变
+    void swapWidget(int index, QWidget* widget);
+
+    //! @brief 容器中的页面被直接销毁时调用, 与卸载相同地移除其名称(或页面池中的实例)并重排其余页面的位置
+    void forgetPage(AbstractPage* page);
+
+    //! @brief 保留页面名称并分配短码, 失败时返回空字符串
+    QString reservePage(const QString& name, const QString& shortcode);
+
+    //! @brief 将页面实例与名称、短码、容器绑定, 并登记到页面管理器
+    void bindPage(const QString& name, const QString& shortcode, AbstractPage* page);
+
+    //! @brief 释放容器中所有页面名称(包括下层页面)的短码, 以及容器保留的短码引用
+    void releaseShortcodes();
+
+    //! @brief 被回收页面的子树占用的一次短码引用
+    struct HeldCode
+    {
+        QSharedPointer<ShortcodeAllocator> scope;   //!< 短码作用域, 为空时为全局作用域
+        QString name;
+    };
+
+    //! @brief 收集容器中所有页面名称(包括下层页面)的短码引用而不释放, 下层容器保留的引用一并转移到 codes
+    void collectShortcodes(QVector<HeldCode>& codes);
+
+    //! @brief 释放 codes 中的短码引用
+    static void releaseHeld(const QVector<HeldCode>& codes);
+
 protected:
     QMap<QString, int> m_names;            //!< name -> QStackedWidget::index
+    QMap<QString, PageFactory> m_factories;//!< name -> 延迟页面的工厂
+    QMap<QString, PagePool> m_pools;       //!< 路由名称 -> 页面池
+    QHash<QString, PageParamSchema> m_schemas; //!< 页面名称(或路由名称) -> 参数声明
     AbstractPage*      m_parentPage;       //!< 挂载容器的父页面, 只有root容器的父页面为nullptr
+    QSharedPointer<ShortcodeAllocator> m_scope; //!< 短码作用域, 为空时使用全局作用域
+    QHash<QString, QVector<HeldCode>> m_heldCodes; //!< 被回收的页面名称 -> 其子树的短码引用, 名称卸载时释放
 };
 
 //! @brief 页面管理器(单例)
 class PagesManager : public QObject
 {
     Q_OBJECT
+    friend class AbstractPage;
+    friend class PagesContainer;
 protected:
     PagesManager(QObject* parent)
         : QObject(parent)
-    {}
-
-public:
-    //! @brief 获取页面管理器实例
-    //! @note 线程不安全
-    static PagesManager& instance() {
-        static PagesManager* __imp = nullptr;
-        if (__imp == nullptr)
-            __imp = new PagesManager(qApp);
-        return *__imp;
+        , m_stackBack(DefaultHistoryCapacity)
+        , m_stackForward(DefaultHistoryCapacity)
+    {
+        m_prewarmTimer.setSingleShot(true);
+        m_prewarmTimer.setInterval(0);
+        connect(&m_prewarmTimer, &QTimer::timeout, this, &PagesManager::prewarmSlice);
+        QMetaType::registerEqualsComparator<PageParam>();
+        m_invokeTail = new InvokeNode();
+        m_invokeHead.storeRelaxed(m_invokeTail);
+        m_snapshots.setMaxCost(0);
     }
 
-    //! @brief 设置根容器
-    void setRootContainer(PagesContainer* container) {
-        Q_ASSERT(container);
-        m_root = container;
-        m_root->m_parentPage = nullptr;
-    }
+    ~PagesManager() {
+        // 此后创建的页面或结束的准备任务不再访问本实例
+        instancePointer().storeRelease(nullptr);
+        for (auto& controls : m_preparing) {
+            for (auto& control : controls) {
+                control.cancel();
+                control.waitForFinished();
+            }
+        }
 
-    //! @brief 返回所有的顶级页面
-    const QMap<QString, AbstractPage*> topPages() {
-        Q_ASSERT(m_root);
-        return m_root->pages();
+        while (InvokeNode* node = popInvoke())
+            abandonInvoke(node->invoke.result);
+        for (auto& invoke : m_invokeBacklog)
+            abandonInvoke(invoke.result);
+        delete m_invokeTail;
     }
 
-    //! @brief 返回当前的活动页面
-    //! @note 当前的活动页面有切只有一个，没有安装任何页面时将返回空指针.
-    AbstractPage* currentPage() const { return m_currentPage; }
-
+public:
+    //! @brief 导航历史记录项
+    struct HistoryEntry
+    {
+        quint32     pageId;     //!< 页面路径的编号, 参见 pathId(), pathOf()
+        QVariantMap params;     //!< 页面参数快照, 仅在 setHistorySnapshots(true) 时记录
+
+        bool operator==(const HistoryEntry& other) const {
+            return pageId == other.pageId && params == other.params;
+        }
+    };
+
+    //! @brief 重复历史记录的处理策略
+    enum HistoryPolicy
+    {
+        KeepDuplicates,         //!< 保留所有记录
+        CollapseConsecutive,    //!< 与栈顶完全相同(页面和参数快照)的记录不再重复压栈
+    };
+
+    //! @brief 历史记录的默认容量
+    static const int DefaultHistoryCapacity = 1024;
+
+    //! @brief 页面切换模式
+    enum SwitchMode
+    {
+        FullSwitch,             //!< 目标路径上的每一跳都触发 pageShow(), pageRaises()
+        DifferentialSwitch,     //!< 仅与上一个当前页面路径不同的跳触发 pageShow(), pageRaises()
+    };
+
+    //! @brief 预热统计
+    struct PrewarmStats
+    {
+        int prewarmed = 0;  //!< 已预热的页面数
+        int hits = 0;       //!< 预热后被访问到的页面数
+        int wasted = 0;     //!< 预热后未被访问就被回收的页面数
+        int unused = 0;     //!< 已预热但尚未被访问的页面数
+        int pending = 0;    //!< 预热队列中等待的页面数
+    };
+
+    //! @brief 快照缓存统计
+    struct SnapshotStats
+    {
+        int hits = 0;           //!< 后退/前进时命中快照的次数
+        int misses = 0;         //!< 后退/前进时没有快照的次数
+        int count = 0;          //!< 缓存中的快照数
+        qint64 bytes = 0;       //!< 缓存中快照占用的字节数
+        qint64 maxBytes = 0;    //!< 缓存的字节预算
+    };
+
+    //! @brief 可见性闸门统计, 参见 AbstractPage::deferUpdate()
+    struct UpdateStats
+    {
+        int immediate = 0;  //!< 页面在屏幕上, 立即执行的更新数
+        int deferred = 0;   //!< 页面不在屏幕上, 被推迟的更新数
+        int coalesced = 0;  //!< 被相同合并键的新更新取代的更新数
+        int flushed = 0;    //!< 页面再次显示时执行的更新数
+        int discarded = 0;  //!< 页面池实例重新绑定数据键时被丢弃的更新数
+        int pending = 0;    //!< 尚未执行的更新数
+        int pages = 0;      //!< 有尚未执行的更新的页面数
+    };
+
+    //! @brief 页面池统计
+    struct PoolStats
+    {
+        int created = 0;    //!< 构造的池实例数
+        int recycled = 0;   //!< 池中实例被重新绑定到其他数据键的次数
+        int trimmed = 0;    //!< 池临时超出容量后被销毁的实例数
+    };
+
+    //! @brief 追踪记录的事件类型
+    enum TraceHook
+    {
+        TraceNavigation,            //!< 一次完整的页面切换, 记录在目标页面上
+        TraceLazyInit,
+        TraceSuspend,
+        TraceResume,
+        TraceEnter,
+        TraceShow,
+        TraceRaises,
+        TraceDescendantChanged,
+        TracePending,
+        TracePrepared,
+        TraceInvoke,
+        TraceEvict,
+        TraceNotify,
+    };
+    Q_ENUM(TraceHook)
+
+    //! @brief 导航记录中的调用类型, 参见 startRecording()
+    enum NavigationCall
+    {
+        CallSwitch,
+        CallGoto,
+        CallBack,
+        CallForward,
+        CallInvoke,
+    };
+    Q_ENUM(NavigationCall)
+
+    static const quint32 RecordMagic = 0x504D4E52;  //!< 导航记录文件的标识 "PMNR"
+    static const quint16 RecordVersion = 1;         //!< 导航记录文件的版本
+    static const quint8  RecordString = 0xFF;       //!< 导航记录中定义字符串的记录类型
+    static const quint32 SessionMagic = 0x504D5353; //!< 会话快照文件的标识 "PMSS"
+    static const quint16 SessionVersion = 1;        //!< 会话快照文件的版本
+
+    //! @brief 主题订阅
+    struct Subscription
+    {
+        AbstractPage* page;
+        AbstractPage::NotifyFlags flags;
+    };
+
+    //! @brief 异步调用统计
+    struct InvokeStats
+    {
+        int pending = 0;        //!< 尚未处理的消息数
+        int delivered = 0;      //!< 已交付的消息数
+        int coalesced = 0;      //!< 被合并掉的消息数
+    };
+
+    //! @brief 某个页面某类事件的耗时统计, 单位为纳秒
+    struct TraceStats
+    {
+        QString   pagePath;
+        QString   shortcodePath;
+        TraceHook hook;
+        int       count = 0;
+        qint64    p50 = 0;
+        qint64    p95 = 0;
+        qint64    p99 = 0;
+        qint64    max = 0;
+    };
+
+    //! @brief 合并导航时, 被跳过的目标页面的参数处理策略
+    enum CoalescePolicy
+    {
+        DropSkippedParams,      //!< 丢弃被跳过的目标页面的参数
+        StoreSkippedParams,     //!< 将参数直接存入被跳过的(已构造的)目标页面的 m_lastParams, 不触发 pageEnter()
+    };
+
+    //! @brief 获取页面管理器实例
+    //! @note 线程不安全, 只能在GUI线程中调用. 实例是 qApp 的子对象, 随 QApplication 一起销毁.
+    static PagesManager& instance() {
+        PagesManager* imp = instancePointer().loadAcquire();
+        if (imp == nullptr) {
+            imp = new PagesManager(qApp);
+            instancePointer().storeRelease(imp);
+        }
+        return *imp;
+    }
+
+    //! @brief 返回已经存在的实例, 不会创建实例
+    //! @return 实例尚未创建或已随 QApplication 销毁时返回空指针
+    //! @note 用于析构函数等可能在实例销毁之后执行的场合, 可以在工作线程中调用.
+    static PagesManager* existingInstance() {
+        return instancePointer().loadAcquire();
+    }
+
+    //! @brief 设置根容器
+    //! @note 不在新页面树中的页面不再受管理: 其准备任务被取消, 订阅与推迟的更新被移除, 快照被清空.
+    void setRootContainer(PagesContainer* container) {
+        Q_ASSERT(container);
+        hideSnapshot();
+        m_root = container;
+        m_root->m_parentPage = nullptr;
+        m_currentPage = nullptr;
+        m_pathIndex.clear();
+        m_routeIndex.clear();
+        m_factoryPages.clear();
+        m_evictedParams.clear();
+        m_evictedIds.clear();
+        m_prewarmedPages.clear();
+        m_snapshots.clear();
+        m_snapshotPending = false;
+        m_pendingSwitches.clear();
+        stopPrewarming();
+
+        // 记录中剩余的页面都还存活(被销毁的页面在析构时已注销), 按新的 root 筛选
+        for (auto page : m_preparing.keys())
+            if (!isAttached(page->m_parent))
+                waitForPrepares(page);
+        for (auto page : m_deferredPages.values())
+            if (!isAttached(page->m_parent))
+                discardUpdates(page);
+        for (const auto& subscribers : QVector<QVector<Subscription>>(m_subscribers))
+            for (const auto& subscriber : subscribers)
+                if (!isAttached(subscriber.page->m_parent))
+                    unsubscribeAll(subscriber.page);
+
+        indexContainer(m_root);
+        emit rootContainerChanged();
+    }
+
+    //! @brief 深度优先(先序)遍历页面树, 不构造延迟页面, 也不分配内存
+    //! @param visitor 形如 bool(const QString& name, AbstractPage* page, int depth) 的可调用对象,
+    //!        page 为空指针表示尚未构造的延迟页面, depth 从 0 开始; 返回 false 时不再深入该页面的子页面.
+    //! @param from 只遍历该页面的子孙页面(不包括其自身), 为空时遍历整棵页面树
+    template<class Visitor>
+    void visitPages(Visitor&& visitor, const AbstractPage* from = nullptr) const {
+        if (from)
+            for (auto c : from->m_containers)
+                visitContainer(c, visitor, 0);
+        else if (m_root)
+            visitContainer(m_root, visitor, 0);
+    }
+
+    //! @brief 返回指定路径上已经构造的页面实例, 不构造延迟页面, 也不触发 pageLazyInit()
+    AbstractPage* existingPage(QString path) const {
+        return m_pathIndex.value(canonicalPath(std::move(path)));
+    }
+
+    //! @brief 返回所有的顶级页面
+    //! @param create 是否构造尚未构造的延迟页面, 为 false 时这些页面对应的值为空指针.
+    const QMap<QString, AbstractPage*> topPages(bool create = true) {
+        Q_ASSERT(m_root);
+        return m_root->pages(create);
+    }
+
+    //! @brief 返回当前的活动页面
+    //! @note 当前的活动页面有切只有一个，没有安装任何页面时将返回空指针.
+    AbstractPage* currentPage() const { return m_currentPage; }
+
     //! @brief 返回指定路径的页面实例
     //! @note 如果页面未经过初始化, 则将触发 pageLazyInit() 事件.
+    //! @note 通过路径索引定位页面, 仅需一次哈希查找, 路径已是规范形式(小写, 以 / 开头)时不产生内存分配.
     AbstractPage* page(QString path) const {
         Q_ASSERT(m_root);
         Q_ASSERT(!path.contains("\\"));
-        path = path.toLower();
 
-        QStringList hops = path.split("/", Qt::SkipEmptyParts);
-        Q_ASSERT(!hops.isEmpty());
+        AbstractPage* page = resolvePage(canonicalPath(std::move(path)));
+        if (page == nullptr)
+            return nullptr;
 
-        AbstractPage* page = nullptr;
-        for (auto n : hops)
-        {
-            if (page == nullptr)
-                page = m_root->page(n);
-            else
-                page = page->subpage(n);
+        PageHops hops;
+        collectHops(page, hops);
+        auto self = const_cast<PagesManager*>(this);
+        for (auto p : hops) {
+            self->initPage(p);
+            p->m_lastUsed = ++self->m_useClock;
+        }
 
-            if (page == nullptr)
-                return nullptr;
+        return page;
+    }
+
+    //! @brief 校验路径索引与逐级遍历页面树的结果是否一致
+    //! @note 用于调试或测试, 会遍历整棵页面树, 但不会构造延迟页面.
+    bool verifyPathIndex() const {
+        Q_ASSERT(m_root);
+        int count = 0;
+        std::function<bool(const PagesContainer*)> walk;
+        walk = [&](const PagesContainer* container) {
+            auto parent = container->parentPage();
+            const QString prefix = parent ? parent->pagePath() : QString();
+            for (auto it = container->begin(); it != container->end(); ++it)
+                if (it.page() == nullptr && m_pathIndex.contains(prefix + "/" + it.name()))
+                    return false;
+
+            bool ok = true;
+            container->visitCreated([&](AbstractPage* page) {
+                QString path = prefix + "/" + page->name();
+                ok = ok && m_pathIndex.value(path) == page && page->pagePath() == path;
+                ++count;
+                for (auto c : page->m_containers)
+                    ok = ok && walk(c);
+            });
+            return ok;
+        };
+        return walk(m_root) && count == m_pathIndex.size();
+    }
+
+    //! @brief 设置页面的内存预算
+    //! @param maxPages 最多保留的延迟页面实例数, 0 表示不限制
+    //! @param maxBytes 延迟页面 pageMemoryUsage() 之和的上限, 0 表示不限制
+    //! @note 超出预算时, 按最近最少使用的顺序销毁不在当前路径上、也不在前进/后退历史中的延迟页面(连同其子页面),
+    //!       销毁前触发 pageEvict() 事件; 页面的 m_lastParams 会被保留, 再次访问时由工厂重新构造并重新 pageLazyInit().
+    void setPageBudget(int maxPages, qint64 maxBytes = 0) {
+        m_budgetPages = qMax(0, maxPages);
+        m_budgetBytes = qMax<qint64>(0, maxBytes);
+        enforcePageBudget();
+    }
+
+    //! @brief 开始异步准备指定路径的页面
+    //! @return 准备任务的 future, 页面未启用异步准备时返回一个已完成的空 future.
+    //! @note 页面已经准备完成或正在准备时, 不会重复准备. 准备完成后将发射 pageReady() 信号.
+    QFuture<QVariant> preparePage(QString path) {
+        auto p = page(std::move(path));
+        if (p == nullptr || !p->m_asyncPrepare) {
+            QFutureInterface<QVariant> done(QFutureInterfaceBase::Finished);
+            return done.future();
+        }
+        startPrepare(p);
+        return p->m_prepare.future();
+    }
+
+    //! @brief 设置是否缓存页面快照
+    //! @param enable 是否启用
+    //! @param maxBytes 快照占用内存的上限, 超出时丢弃最久未使用的快照
+    //! @note 启用后, 当前页面离开屏幕时抓取其快照; pageBack(), pageForward() 时立即在目标页面的位置显示其快照,
+    //!       在 pageShow() 完成(启用异步准备的页面为 pagePrepared() 完成)后移除快照, 显示实际页面.
+    //! @see AbstractPage::setSnapshotEnabled(), AbstractPage::invalidateSnapshot()
+    void setSnapshotCache(bool enable, qint64 maxBytes = 64 * 1024 * 1024) {
+        m_snapshotCache = enable;
+        m_snapshots.setMaxCost(enable ? int(qMin<qint64>(maxBytes / 1024, INT_MAX)) : 0);
+        if (!enable)
+            hideSnapshot();
+    }
+
+    bool snapshotCache() const { return m_snapshotCache; }
+
+    //! @brief 返回快照缓存统计
+    SnapshotStats snapshotStats() const {
+        SnapshotStats stats = m_snapshotStats;
+        stats.count = m_snapshots.size();
+        stats.bytes = qint64(m_snapshots.totalCost()) * 1024;
+        stats.maxBytes = qint64(m_snapshots.maxCost()) * 1024;
+        return stats;
+    }
+
+    //! @brief 丢弃所有快照并清空统计
+    void clearSnapshots() {
+        m_snapshots.clear();
+        m_snapshotStats = {};
+    }
+
+    //! @brief 页面是否在屏幕上
+    //! @note 页面及其各级父页面都是所在容器的当前页面时, 页面在屏幕上: 
+    //!       即当前路径上的页面, 以及这些页面中其他(兄弟)容器的当前页面.
+    bool isOnScreen(const AbstractPage* page) const {
+        for (auto p = page; p && p->m_parent; p = p->parentPage()) {
+            if (p->m_parent->currentWidget() != p)
+                return false;
+            if (p->m_parent == m_root)
+                return true;
+        }
+        return false;
+    }
+
+    //! @brief 返回可见性闸门统计
+    UpdateStats updateStats() const {
+        UpdateStats stats = m_updateStats;
+        stats.pages = m_deferredPages.size();
+        for (auto page : m_deferredPages)
+            stats.pending += page->m_deferredUpdates.size();
+        return stats;
+    }
+
+    void resetUpdateStats() {
+        m_updateStats = {};
+    }
+
+    //! @brief 设置是否预热可能访问的下一个页面
+    //! @param enable 是否启用
+    //! @param candidates 每次导航后最多预热的页面数
+    //! @param sliceMs 每个空闲时间片的预算(毫秒)
+    //! @note 启用后, 根据 pageGoto() 学习页面间的跳转频率, 每次导航后将当前页面最可能跳转到的页面放入预热队列,
+    //!       在事件循环空闲时逐个构造并触发 pageLazyInit(); 收到用户输入(鼠标、键盘、触摸)时立即停止预热.
+    void setPrewarming(bool enable, int candidates = 3, int sliceMs = 4) {
+        m_prewarming = enable;
+        m_prewarmCandidates = qMax(1, candidates);
+        m_prewarmSliceMs = qMax(1, sliceMs);
+        if (enable)
+            qApp->installEventFilter(this);
+        else {
+            qApp->removeEventFilter(this);
+            stopPrewarming();
+        }
+    }
+
+    bool prewarming() const { return m_prewarming; }
+
+    //! @brief 返回预热统计
+    PrewarmStats prewarmStats() const {
+        PrewarmStats stats = m_prewarmStats;
+        stats.unused = m_prewarmedPages.size();
+        stats.pending = m_prewarmQueue.size();
+        return stats;
+    }
+
+    //! @brief 返回页面池统计, 参见 PagesContainer::installPagePool()
+    PoolStats poolStats() const {
+        return m_poolStats;
+    }
+
+    //! @brief 清空预热统计以及已学习的跳转频率
+    void resetPrewarmStats() {
+        m_prewarmStats = {};
+        m_prewarmedPages.clear();
+        m_transitions.clear();
+    }
+
+    //! @brief 设置是否追踪页面事件的耗时
+    //! @param capacity 环形缓冲区的容量(事件数), 向上取整为 2 的幂, 写满后覆盖最早的事件
+    //! @note 启用后, 记录每次页面切换、pageInvoke() 以及各个生命周期事件的耗时;
+    //!       关闭时每个事件只多一次分支判断, 可以在生产环境中按需开启.
+    void setTracing(bool enable, int capacity = 65536) {
+        m_tracing = false;
+        if (!enable)
+            return;
+
+        quint64 size = 1;
+        while (size < quint64(qMax(1, capacity)))
+            size <<= 1;
+        if (size != m_traceMask + 1 || m_traceSlots.isNull()) {
+            m_traceSlots.reset(new TraceSlot[size]);
+            m_traceMask = size - 1;
+            m_traceHead.storeRelaxed(0);
+        }
+        if (!m_traceClock.isValid())
+            m_traceClock.start();
+        m_tracing = true;
+    }
+
+    bool tracing() const { return m_tracing; }
+
+    //! @brief 清空已记录的追踪事件
+    void clearTrace() {
+        for (quint64 i = 0; !m_traceSlots.isNull() && i <= m_traceMask; ++i)
+            m_traceSlots[i].seq.storeRelaxed(0);
+        m_traceHead.storeRelaxed(0);
+    }
+
+    //! @brief 将追踪事件导出为 Chrome trace-event 格式的 JSON
+    //! @note 可以在 chrome://tracing 或 Perfetto 中打开, 事件参数中带有页面路径与短码路径.
+    QByteArray chromeTrace() const {
+        QJsonArray events;
+        QHash<quint32, QString> codes;
+        visitTrace([&](const TraceSlot& slot) {
+            QString path = pathOf(slot.pageId);
+            auto code = codes.find(slot.pageId);
+            if (code == codes.end())
+                code = codes.insert(slot.pageId, toShortcodePath(path));
+
+            QJsonObject event;
+            event["name"] = QLatin1String(traceHookName(TraceHook(slot.hook)));
+            event["cat"]  = slot.hook == TraceNavigation ? QLatin1String("navigation") : QLatin1String("page");
+            event["ph"]   = QLatin1String("X");
+            event["ts"]   = slot.start / 1000.0;
+            event["dur"]  = slot.duration / 1000.0;
+            event["pid"]  = 1;
+            event["tid"]  = 1;
+            event["args"] = QJsonObject{ { "path", path }, { "shortcode", code.value() } };
+            events.append(event);
+        });
+        return QJsonDocument(QJsonObject{ { "traceEvents", events }, { "displayTimeUnit", "ns" } }).toJson(QJsonDocument::Compact);
+    }
+
+    //! @brief 按页面与事件类型汇总追踪事件的耗时分布
+    //! @return 统计结果, 按页面路径与事件类型排序
+    QVector<TraceStats> traceStats() const {
+        QMap<QPair<QString, int>, QVector<qint64>> samples;
+        visitTrace([&](const TraceSlot& slot) {
+            samples[qMakePair(pathOf(slot.pageId), int(slot.hook))].append(slot.duration);
+        });
+
+        QVector<TraceStats> result;
+        result.reserve(samples.size());
+        for (auto it = samples.begin(); it != samples.end(); ++it) {
+            auto& durations = it.value();
+            std::sort(durations.begin(), durations.end());
+            auto percentile = [&](int p) {
+                return durations[qMin(durations.size() - 1, (durations.size() * p + 99) / 100 - 1)];
+            };
+
+            TraceStats stats;
+            stats.pagePath = it.key().first;
+            stats.shortcodePath = toShortcodePath(stats.pagePath);
+            stats.hook = TraceHook(it.key().second);
+            stats.count = durations.size();
+            stats.p50 = percentile(50);
+            stats.p95 = percentile(95);
+            stats.p99 = percentile(99);
+            stats.max = durations.last();
+            result.append(stats);
+        }
+        return result;
+    }
+
+    //! @brief 返回追踪事件类型的名称, 与对应的页面事件同名
+    static const char* traceHookName(TraceHook hook) {
+        static const char* const names[] = {
+            "pageSwitch", "pageLazyInit", "pageSuspend", "pageResume", "pageEnter", "pageShow",
+            "pageRaises", "pageDescendantChanged", "pagePending", "pagePrepared", "pageInvoke", "pageEvict",
+            "pageNotify",
+        };
+        return hook >= 0 && hook <= TraceNotify ? names[hook] : "";
+    }
+
+    //! @brief 开始将导航调用记录到 device 中
+    //! @param device 已打开的可写设备, 记录期间必须保持有效, 不会转移所有权
+    //! @note 记录 pageSwitch(), pageGoto(), pageBack(), pageForward(), pageInvoke() 的调用者路径、目标路径、
+    //!       参数以及开始时间与耗时, 只记录最外层的调用. 路径在文件中只出现一次, 之后以编号引用.
+    //!       参数通过 QDataStream 序列化, 无法序列化的值(例如 PageParam)不会被记录.
+    //! @see NavigationReplayer
+    void startRecording(QIODevice* device) {
+        Q_ASSERT(device && device->isWritable());
+        m_recorder.reset(new QDataStream(device));
+        m_recorder->setVersion(QDataStream::Qt_5_15);
+        *m_recorder << RecordMagic << RecordVersion;
+        m_recordStrings.clear();
+        m_recordClock.start();
+    }
+
+    //! @brief 停止记录导航调用
+    void stopRecording() {
+        m_recorder.reset();
+        m_recordStrings.clear();
+    }
+
+    bool isRecording() const { return !m_recorder.isNull(); }
+
+    //! @brief 页面路径是否存在, 不会构造延迟页面
+    //! @note 路径经过尚未构造的延迟页面时, 无法确认其下的子页面是否存在, 此时返回 true.
+    bool hasPage(QString path) const {
+        if (m_root == nullptr)
+            return false;
+        return visitHops(canonicalPath(std::move(path)), [](PagesContainer*, const QString&, int) {});
+    }
+
+    //! @brief 深度链接的解析结果
+    struct Link
+    {
+        QString     path;       //!< 规范的页面路径
+        QVariantMap params;     //!< 页面参数, 发往上级页面的参数以其路径为键, 与 pageSwitch() 相同
+        QString     error;      //!< 解析或校验失败的原因, 为空表示链接有效
+        bool        verified = true; //!< 路径是否已确认存在, 经过尚未构造的延迟页面时其下的部分无法确认, 参数也未按其声明校验
+
+        bool isValid() const { return error.isEmpty(); }
+    };
+
+    //! @brief 解析深度链接
+    //! @param link 形如 /view/photos?device=3&sort=date 的页面路径加查询参数, 
+    //!        不以 / 开头时视为短码路径, 例如 vwph?device=3; # 之后的部分被忽略.
+    //! @note 查询参数按目标页面(以及路径上各级页面)的 PagesContainer::setParamSchema() 声明转换类型并校验:
+    //!       声明了参数的页面不接受未声明的参数, 缺少必需的参数时链接无效; 未声明参数的页面接受任意参数, 类型均为字符串.
+    //!       形如 view.layout=grid 的参数名中, 点号之前为路径上某一级页面的名称时, 该参数发往那一级页面.
+    //! @note 除了参数值需要百分号解码以外, 解析过程直接在 link 上进行, 不产生中间字符串; 不会构造延迟页面.
+    //!       因此路径经过尚未构造的延迟页面时, 其下的部分只能视为有效, 此时 Link::verified 为 false.
+    Link parseLink(QStringView link) const {
+        Link result;
+        parseLink(link, &result.path, &result.params, &result.error, &result.verified);
+        return result;
+    }
+
+    //! @brief 打开深度链接, 相当于以解析结果调用 pageGoto()
+    //! @return 链接无效时返回 false, 不发生跳转
+    //! @note 路径经过尚未构造的延迟页面时, 先构造路径上的页面, 再重新解析并校验, 页面不存在时返回 false.
+    bool openLink(QString callerPagePath, QStringView link) {
+        Link parsed = parseLink(link);
+        if (parsed.isValid() && !parsed.verified) {
+            if (page(parsed.path) == nullptr)
+                return false;
+            parsed = parseLink(link);
+        }
+        if (!parsed.isValid())
+            return false;
+        pageGoto(std::move(callerPagePath), std::move(parsed.path), std::move(parsed.params));
+        return true;
+    }
+
+    //! @brief 批量校验深度链接, 例如启动时校验保存的书签
+    //! @param verified 不为空时写入与 links 一一对应的 Link::verified, 为 false 的链接经过尚未构造的延迟页面, 
+    //!        其下的部分无法确认, 参见 parseLink()
+    //! @return 与 links 一一对应的错误信息, 链接有效时为空字符串
+    //! @note 只解析与校验, 不构建参数表, 也不会构造延迟页面.
+    QStringList validateLinks(const QStringList& links, QVector<bool>* verified = nullptr) const {
+        QStringList errors;
+        errors.reserve(links.size());
+        if (verified) {
+            verified->clear();
+            verified->reserve(links.size());
+        }
+        QString path, error;
+        bool known = true;
+        for (const auto& link : links) {
+            parseLink(link, &path, nullptr, &error, &known);
+            errors.append(error);
+            if (verified)
+                verified->append(known);
+        }
+        return errors;
+    }
+
+    //! @brief 保存会话快照
+    //! @note 快照包括当前页面路径、前进/后退历史(含参数快照)以及各页面的 m_lastParams,
+    //!       其中尚未构造或已被回收的页面的参数同样会被保存. 文件以带版本的二进制格式原子地写入.
+    //! @note 与导航记录相同, 无法序列化的参数值(例如 PageParam)不会被保存, 参见 streamableParams().
+    bool saveSession(const QString& fileName) {
+        QHash<QString, quint32> ids;
+        QVector<QString> strings;
+        auto intern = [&](const QString& path) {
+            auto it = ids.constFind(path);
+            if (it != ids.constEnd())
+                return it.value();
+            quint32 id = quint32(strings.size());
+            ids.insert(path, id);
+            strings.append(path);
+            return id;
+        };
+
+        // 快照可能正映射着同一个文件, 先将恢复参数复制出映射再释放, 之后才能覆盖文件
+        releaseSessionFile();
+
+        // 页面参数: 存活页面 > 被回收页面 > 尚未访问的恢复参数
+        QVector<QPair<quint32, QByteArray>> params;
+        for (auto it = m_pathIndex.constBegin(); it != m_pathIndex.constEnd(); ++it)
+            if (!it.value()->m_lastParams.isEmpty())
+                params.append({ intern(it.key()), encodeParams(it.value()->m_lastParams) });
+        for (auto it = m_evictedParams.constBegin(); it != m_evictedParams.constEnd(); ++it)
+            if (!ids.contains(it.key()))
+                params.append({ intern(it.key()), encodeParams(it.value()) });
+        for (auto it = m_sessionParams.constBegin(); it != m_sessionParams.constEnd(); ++it)
+            if (!ids.contains(it.key()))
+                params.append({ intern(it.key()), it.value() });
+
+        quint32 current = m_currentPage ? intern(m_currentPage->pagePath()) : NoPathId;
+        QVector<quint32> history[2];
+        const History* stacks[2] = { &m_stackBack, &m_stackForward };
+        for (int s = 0; s < 2; ++s)
+            for (int i = stacks[s]->firstIndex(); i <= stacks[s]->lastIndex() && !stacks[s]->isEmpty(); ++i)
+                history[s].append(intern(m_idPaths[int(stacks[s]->at(i).pageId)]));
+
+        QSaveFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_5_15);
+        out << SessionMagic << SessionVersion;
+        out << quint32(strings.size());
+        for (const auto& path : strings)
+            out << path;
+        out << current;
+        for (int s = 0; s < 2; ++s) {
+            out << quint32(history[s].size());
+            for (int i = 0; i < history[s].size(); ++i)
+                out << history[s][i] << streamableParams(stacks[s]->at(stacks[s]->firstIndex() + i).params);
+        }
+        out << quint32(params.size());
+        for (const auto& param : params) {
+            out << param.first;
+            out.writeBytes(param.second.constData(), uint(param.second.size()));
+        }
+
+        return out.status() == QDataStream::Ok && file.commit();
+    }
+
+    //! @brief 恢复会话快照
+    //! @param switchToCurrent 是否切换到快照中的当前页面, 该页面在当前的页面树中已不存在时不切换
+    //! @return 文件不存在、格式或版本不匹配时返回 false, 此时不改变任何状态
+    //! @note 文件被映射到内存中, 历史立即恢复, 各页面的参数则保留在映射中, 直到页面首次被访问时
+    //!       (在 pageLazyInit() 之前)才解码并写入其 m_lastParams, 已有参数的页面不会被覆盖.
+    bool restoreSession(const QString& fileName, bool switchToCurrent = true) {
+        QScopedPointer<QFile> file(new QFile(fileName));
+        if (!file->open(QIODevice::ReadOnly) || file->size() <= 0)
+            return false;
+        uchar* data = file->map(0, file->size());
+        if (data == nullptr)
+            return false;
 
-            if (!page->property("initialized").toBool()) {
-                page->pageLazyInit();
-                page->setProperty("initialized", true);
+        QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), int(file->size()));
+        QDataStream in(bytes);
+        in.setVersion(QDataStream::Qt_5_15);
+
+        quint32 magic = 0;
+        quint16 version = 0;
+        in >> magic >> version;
+        if (magic != SessionMagic || version != SessionVersion)
+            return false;
+
+        quint32 count = 0;
+        in >> count;
+        QVector<QString> strings;
+        for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            QString path;
+            in >> path;
+            strings.append(path);
+        }
+        auto valid = [&](quint32 id) { return id < quint32(strings.size()); };
+
+        quint32 current = NoPathId;
+        in >> current;
+
+        QVector<QPair<quint32, QVariantMap>> history[2];
+        for (int s = 0; s < 2; ++s) {
+            in >> count;
+            for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+                QPair<quint32, QVariantMap> entry;
+                in >> entry.first >> entry.second;
+                if (!valid(entry.first))
+                    return false;
+                history[s].append(entry);
             }
         }
 
-        return page;
+        // 页面参数只记录其在映射中的位置
+        QHash<QString, QByteArray> params;
+        in >> count;
+        for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            quint32 id = 0, length = 0;
+            in >> id >> length;
+            qint64 pos = in.device()->pos();
+            if (!valid(id) || in.skipRawData(int(length)) != int(length))
+                return false;
+            params.insert(strings[int(id)], QByteArray::fromRawData(bytes.constData() + pos, int(length)));
+        }
+        if (in.status() != QDataStream::Ok)
+            return false;
+
+        releaseSessionFile();
+        History* stacks[2] = { &m_stackBack, &m_stackForward };
+        for (int s = 0; s < 2; ++s) {
+            stacks[s]->clear();
+            for (const auto& entry : history[s]) {
+                stacks[s]->append({ pathId(strings[int(entry.first)]), entry.second });
+                if (!stacks[s]->areIndexesValid())
+                    stacks[s]->normalizeIndexes();
+            }
+        }
+        m_sessionParams = params;
+        if (!m_sessionParams.isEmpty())
+            m_sessionFile.reset(file.take());
+
+        // 延迟页面重新构造后可能不再包含保存时的子页面, hasPage() 无法确认, 因此先解析页面
+        if (switchToCurrent && valid(current) && page(strings[int(current)]))
+            pageSwitch({}, strings[int(current)], {});
+        return true;
+    }
+
+    //! @brief 返回指定路径页面的生命周期状态
+    //! @note 不会构造页面; 被回收的页面返回 Evicted, 路径不存在或延迟页面尚未构造时返回 Constructed.
+    AbstractPage::PageState pageState(QString path) const {
+        path = canonicalPath(std::move(path));
+        if (auto p = m_pathIndex.value(path))
+            return p->m_state;
+        auto it = m_pathIds.constFind(path);
+        if (it != m_pathIds.constEnd() && m_evictedIds.contains(it.value()))
+            return AbstractPage::Evicted;
+        return AbstractPage::Constructed;
     }
 
+    //! @brief 返回当前存活的延迟页面实例数
+    int livePageCount() const { return m_factoryPages.size(); }
+
     QSet<PagesContainer*> containers(QString path) const {
         Q_ASSERT(m_root);
         if (path == "/")
@@ -472,9 +1915,95 @@ public:
         return {};
     }
 
-    QStack<QString>& stackBack() { return m_stackBack; }
+    //! @brief 返回后退历史的副本, 栈顶为最近的记录
+    //! @note 需要复制整个历史, 仅为兼容保留, 请使用 backCount(), backEntry() 检查历史.
+    //! @note 历史改为记录路径编号后不再返回内部栈的引用, 修改副本不会影响历史, 请使用 clearBack(), trimHistory() 修改历史.
+    Q_DECL_DEPRECATED_X("Use backCount()/backEntry() to inspect and clearBack() to modify the history")
+    QStack<QString> stackBack() const { return historyPaths(m_stackBack); }
 
-    QStack<QString>& stackForward() { return m_stackForward; }
+    //! @brief 返回前进历史的副本, 栈顶为最近的记录
+    //! @note 需要复制整个历史, 仅为兼容保留, 请使用 forwardCount(), forwardEntry() 检查历史.
+    //! @note 同 stackBack(), 修改副本不会影响历史, 请使用 clearForward(), trimHistory() 修改历史.
+    Q_DECL_DEPRECATED_X("Use forwardCount()/forwardEntry() to inspect and clearForward() to modify the history")
+    QStack<QString> stackForward() const { return historyPaths(m_stackForward); }
+
+    //! @brief 后退历史中的记录数
+    int backCount() const { return m_stackBack.size(); }
+
+    //! @brief 前进历史中的记录数
+    int forwardCount() const { return m_stackForward.size(); }
+
+    //! @brief 返回后退历史中的第 i 条记录, 0 为最近的记录
+    const HistoryEntry& backEntry(int i) const {
+        Q_ASSERT(i >= 0 && i < m_stackBack.size());
+        return m_stackBack.at(m_stackBack.lastIndex() - i);
+    }
+
+    //! @brief 返回前进历史中的第 i 条记录, 0 为最近的记录
+    const HistoryEntry& forwardEntry(int i) const {
+        Q_ASSERT(i >= 0 && i < m_stackForward.size());
+        return m_stackForward.at(m_stackForward.lastIndex() - i);
+    }
+
+    //! @brief 返回路径对应的编号, 路径尚未出现过时为其分配新的编号
+    quint32 pathId(const QString& path) {
+        QString canonical = canonicalPath(path);
+        auto it = m_pathIds.constFind(canonical);
+        if (it != m_pathIds.constEnd())
+            return it.value();
+        quint32 id = quint32(m_idPaths.size());
+        m_pathIds.insert(canonical, id);
+        m_idPaths.append(canonical);
+        return id;
+    }
+
+    //! @brief 返回编号对应的路径
+    QString pathOf(quint32 id) const {
+        return id < quint32(m_idPaths.size()) ? m_idPaths[int(id)] : QString();
+    }
+
+    //! @brief 设置前进、后退历史各自的容量, 超出时丢弃最旧的记录
+    void setHistoryCapacity(int capacity) {
+        capacity = qMax(1, capacity);
+        m_stackBack.setCapacity(capacity);
+        m_stackForward.setCapacity(capacity);
+    }
+
+    int historyCapacity() const { return m_stackBack.capacity(); }
+
+    //! @brief 设置重复历史记录的处理策略
+    void setHistoryPolicy(HistoryPolicy policy) { m_historyPolicy = policy; }
+
+    HistoryPolicy historyPolicy() const { return m_historyPolicy; }
+
+    //! @brief 设置是否在历史记录中保存页面参数快照
+    //! @note 启用后, 离开页面时记录其 m_lastParams, pageBack()/pageForward() 未指定参数时将以快照作为参数进入页面.
+    void setHistorySnapshots(bool enable) { m_historySnapshots = enable; }
+
+    bool historySnapshots() const { return m_historySnapshots; }
+
+    //! @brief 丢弃最旧的历史记录, 使前进、后退历史分别不超过 maxBack, maxForward 条
+    //! @param maxForward 小于 0 时与 maxBack 相同
+    void trimHistory(int maxBack, int maxForward = -1) {
+        if (maxForward < 0)
+            maxForward = maxBack;
+        while (m_stackBack.size() > qMax(0, maxBack))
+            m_stackBack.removeFirst();
+        while (m_stackForward.size() > qMax(0, maxForward))
+            m_stackForward.removeFirst();
+    }
+
+    //! @brief 清空前进、后退历史
+    void clearHistory() {
+        m_stackBack.clear();
+        m_stackForward.clear();
+    }
+
+    //! @brief 清空后退历史
+    void clearBack() { m_stackBack.clear(); }
+
+    //! @brief 清空前进历史
+    void clearForward() { m_stackForward.clear(); }
 
     bool canForward() const {
         return !m_stackForward.isEmpty();
@@ -484,152 +2013,1886 @@ public:
         return !m_stackBack.isEmpty();
     }
 
+    //! @brief 设置页面切换模式
+    //! @note DifferentialSwitch 模式下, 新旧路径公共前缀上的页面(目标页面除外)不再触发 pageShow(), pageRaises(),
+    //!       而是触发 pageDescendantChanged(); 收到 pageEnter() 的页面仍会触发 pageShow(), pageRaises().
+    void setSwitchMode(SwitchMode mode) { m_switchMode = mode; }
+
+    SwitchMode switchMode() const { return m_switchMode; }
+
+    //! @brief 设置是否合并导航
+    //! @note 启用后, pageSwitch(), pageGoto(), pageBack(), pageForward() 只记录请求(历史记录仍立即按调用产生),
+    //!       待事件循环下一次运行时仅切换到最后一个目标页面, 整批请求只发射一次 currentPageChanged() 信号.
+    //!       参数的合并规则:
+    //!         1. 与最终目标相同的请求, 其参数按调用顺序合并, 后者覆盖前者的同名键;
+    //!         2. 被跳过的目标页面的参数按 setCoalescePolicy() 处理.
+    //! @note 关闭时将立即执行尚未处理的请求.
+    void setNavigationCoalescing(bool enable) {
+        m_coalescing = enable;
+        if (!enable)
+            flushNavigation();
+    }
+
+    bool navigationCoalescing() const { return m_coalescing; }
+
+    //! @brief 设置合并导航时, 被跳过的目标页面的参数处理策略
+    void setCoalescePolicy(CoalescePolicy policy) { m_coalescePolicy = policy; }
+
+    CoalescePolicy coalescePolicy() const { return m_coalescePolicy; }
+
+    //! @brief 立即执行合并导航中尚未处理的请求
+    void flushNavigation() {
+        m_flushScheduled = false;
+        if (m_pendingSwitches.isEmpty())
+            return;
+
+        QVector<PendingSwitch> pending;
+        pending.swap(m_pendingSwitches);
+
+        const QString callee = pending.last().callee;
+        QVariantMap params;
+        for (auto& request : pending)
+        {
+            if (request.callee == callee) {
+                if (params.isEmpty())
+                    params = std::move(request.params);
+                else
+                    for (auto it = request.params.constBegin(); it != request.params.constEnd(); ++it)
+                        params.insert(it.key(), it.value());
+            }
+            else if (m_coalescePolicy == StoreSkippedParams && !request.params.isEmpty()) {
+                if (auto page = m_pathIndex.value(request.callee))
+                    page->m_lastParams = std::move(request.params);
+            }
+        }
+
+        switchPage(pending.first().caller, callee, std::move(params));
+    }
+
     //! @brief 页面切换
     //! @param callerPagePath 发起切换的页面路径, 如果为空, 则表示由外部触发
     //! @param calleePagePath 要切换到的页面路径, 大小写不敏感
     //! @param params 页面参数, 如果不为空, 目标页面将会触发 pageEnter() 事件。
     //! @note 这种方式产生的切换不会产生历史, 页面成功切换后将发射 currentPageChanged() 信号。
-    void pageSwitch(QString callerPagePath, QString calleePagePath, const QVariantMap& params)
+    //! @note 启用合并导航时, 切换将推迟到事件循环下一次运行时, 参见 setNavigationCoalescing().
+    //! @note params 按值传入并一直移动到目标页面的 m_lastParams, 传入右值时整个过程不会复制参数.
+    void pageSwitch(QString callerPagePath, QString calleePagePath, QVariantMap params)
+    {
+        RecordScope record(this, CallSwitch, callerPagePath, calleePagePath, params);
+        if (!m_coalescing) {
+            switchPage(std::move(callerPagePath), std::move(calleePagePath), std::move(params));
+            return;
+        }
+
+        m_pendingSwitches.append({ 
+            callerPagePath.toLower(), canonicalPath(std::move(calleePagePath)), std::move(params) });
+        if (!m_flushScheduled) {
+            m_flushScheduled = true;
+            QMetaObject::invokeMethod(this, [this] { flushNavigation(); }, Qt::QueuedConnection);
+        }
+    }
+
+protected:
+    //! @brief 立即执行页面切换, 参见 pageSwitch()
+    void switchPage(QString callerPagePath, QString calleePagePath, QVariantMap params)
     {
         Q_ASSERT(m_root);
         Q_ASSERT(!calleePagePath.contains("\\"));
 
-        auto callPageEnter = [](auto & page, auto const& path, auto params) {
-            page->pageEnter(path, params);
-            page->m_lastParams = params;
+        callerPagePath = callerPagePath.toLower();
+
+        auto callPageEnter = [this, &callerPagePath](AbstractPage* page, QVariantMap params) {
+            traced(TraceEnter, page, [&] { page->pageEnter(callerPagePath, params); });
+            page->m_lastParams = std::move(params);
+            return true;
         };
 
-        callerPagePath = callerPagePath.toLower();
-        calleePagePath = calleePagePath.toLower();
+        calleePagePath = canonicalPath(std::move(calleePagePath));
 
-        QStringList hops = calleePagePath.split("/", Qt::SkipEmptyParts);
-        Q_ASSERT(!hops.isEmpty());
+        const bool tracing = m_tracing;
+        const qint64 traceStart = tracing ? m_traceClock.nsecsElapsed() : 0;
 
-        AbstractPage* page = nullptr;
-        for (auto n : hops)
-        {
-            if (page == nullptr)
-                page = m_root->page(n);
-            else
-                page = page->subpage(n);
+        AbstractPage* target = resolvePage(calleePagePath);
+        Q_ASSERT(target);
+        if (target == nullptr)
+            return;
+
+        PageHops hops;
+        collectHops(target, hops);
+
+        // 当前页面离开屏幕前抓取快照, 后退/前进时先显示目标页面的快照
+        if (m_snapshotCache) {
+            hideSnapshot();
+            if (m_currentPage && m_currentPage != target)
+                grabSnapshot(m_currentPage);
+            if (std::exchange(m_snapshotPending, false))
+                showSnapshot(target);
+        }
 
-            Q_ASSERT(page);
-            if (!page->property("initialized").toBool()) {
-                page->pageLazyInit();
-                page->setProperty("initialized", true);
+        // 离开当前路径的页面被挂起
+        PageHops previous;
+        if (m_currentPage)
+            collectHops(m_currentPage, previous);
+        for (auto page : previous) {
+            if (page->m_state == AbstractPage::Active && !std::count(hops.begin(), hops.end(), page)) {
+                page->m_state = AbstractPage::Suspended;
+                traced(TraceSuspend, page, [page] { page->pageSuspend(); });
             }
+        }
+
+        // 差量切换: 与上一个当前页面路径的公共前缀
+        int common = 0;
+        if (m_switchMode == DifferentialSwitch) {
+            while (common < hops.size() && common < previous.size() && hops[common] == previous[common])
+                ++common;
+        }
+
+        // 取消不再位于目标路径上的异步准备
+        for (auto it = m_preparing.constBegin(); it != m_preparing.constEnd(); ++it)
+            if (!std::count(hops.begin(), hops.end(), it.key()))
+                it.key()->m_prepare.cancel();
+
+        for (int i = 0; i < hops.size(); ++i)
+        {
+            auto page = hops[i];
+            initPage(page);
+            page->m_lastUsed = ++m_useClock;
+            if (!m_prewarmedPages.isEmpty() && m_prewarmedPages.remove(page))
+                ++m_prewarmStats.hits;
+
+            if (page->m_state != AbstractPage::Active) {
+                page->m_state = AbstractPage::Active;
+                traced(TraceResume, page, [page] { page->pageResume(); });
+            }
+
+            // 目标页面是最后一级, 其参数直接移入页面; 按路径指定的参数若本身就是 QVariantMap, 则共享而不转换
+            bool entered = false;
+            if (!params.isEmpty()) {
+                auto it = params.constFind(page->pagePath());
+                if (it != params.constEnd())
+                    entered = callPageEnter(page, it.value().userType() == QMetaType::QVariantMap
+                        ? *static_cast<const QVariantMap*>(it.value().constData())
+                        : it.value().value<QVariantMap>());
+                else if (page == target)
+                    entered = callPageEnter(page, std::move(params));
+            }
+
+            if (page->m_asyncPrepare)
+                startPrepare(page);
+
+            if (i < common && page != target && !entered) {
+                traced(TraceDescendantChanged, page, [&] { 
+                    page->pageDescendantChanged(m_currentPage->pagePath(), calleePagePath); 
+                });
+                continue;
+            }
+
+            traced(TraceShow, page, [page] { page->pageShow(); });
+            traced(TraceRaises, page, [page] { page->pageRaises(); });
+        }
+
+        m_currentPage = target;
+        if (m_snapshotTarget && target->isPrepared())
+            hideSnapshot();
+        emit currentPageChanged(callerPagePath, calleePagePath);
+        enforcePageBudget();
+        if (tracing && m_tracing)
+            traceRecord(TraceNavigation, target, traceStart);
+        if (m_prewarming)
+            schedulePrewarm(calleePagePath);
+    }
+
+public:
+    //! @brief 页面跳转
+    //! @param callerPagePath 发起跳转的页面路径, 如果为空, 则表示由外部触发
+    //! @param calleePagePath 要跳转的页面路径, 大小写不敏感
+    //! @param params 页面参数, 如果不为空, 目标页面将会触发 pageEnter() 事件。
+    //! @note 这种方式产生的切换将产生历史, 这意味着可以通过 pageBack() 和 pageForward() 进行导航, 页面成功跳转后将发射 currentPageChanged() 信号。
+    void pageGoto(QString callerPagePath, QString calleePagePath, QVariantMap params) {
+        RecordScope record(this, CallGoto, callerPagePath, calleePagePath, params);
+        callerPagePath = callerPagePath.toLower();
+        calleePagePath = calleePagePath.toLower();
+
+        if (callerPagePath.size()) {
+            pushHistory(m_stackBack, callerPagePath);
+            if (m_prewarming)
+                ++m_transitions[pathId(callerPagePath)][pathId(calleePagePath)];
+        }
+        m_stackForward.clear();
+        pageSwitch(std::move(callerPagePath), std::move(calleePagePath), std::move(params));
+    }
+
+    //! @brief 返回到前一个页面
+    //! @param callerPagePath 发起跳转的页面路径, 不能为空.
+    void pageForward(QString callerPagePath, QVariantMap params) {
+        RecordScope record(this, CallForward, callerPagePath, {}, params);
+        Q_ASSERT(canForward());
+        if (!canForward())
+            return;
+        HistoryEntry entry = m_stackForward.takeLast();
+        pushHistory(m_stackBack, callerPagePath);
+        m_snapshotPending = m_snapshotCache;
+        pageSwitch(callerPagePath.toLower(), pathOf(entry.pageId), 
+            params.isEmpty() ? std::move(entry.params) : std::move(params));
+    }
+
+    //! @brief 返回到后一个页面
+    //! @param callerPagePath 发起跳转的页面路径, 不能为空.
+    void pageBack(QString callerPagePath, QVariantMap params) {
+        RecordScope record(this, CallBack, callerPagePath, {}, params);
+        Q_ASSERT(canBack());
+        if (!canBack())
+            return;
+        HistoryEntry entry = m_stackBack.takeLast();
+        pushHistory(m_stackForward, callerPagePath);
+        m_snapshotPending = m_snapshotCache;
+        pageSwitch(callerPagePath.toLower(), pathOf(entry.pageId), 
+            params.isEmpty() ? std::move(entry.params) : std::move(params));
+    }
+
+    //! @brief 页面调用方法
+    //! @param callerPagePath 发起调用的页面路径, 如果为空, 则表示由外部触发。
+    //! @param calleePagePath 要调用的页面路径, 大小写不敏感
+    //! @param params 页面参数, 目标页面将会触发 pageInvoke() 事件。
+    //! @return 调用结果, 由页面的 pageInvoke() 事件返回; 目标页面不存在时返回空的 QVariant.
+    QVariant pageInvoke(QString callerPagePath, QString calleePagePath, const QVariantMap& params) {
+        RecordScope record(this, CallInvoke, callerPagePath, calleePagePath, params);
+        QVariant result;
+        AbstractPage* callee = page(std::move(calleePagePath));
+        if (callee == nullptr)
+            return result;
+        traced(TraceInvoke, callee, [&] { result = callee->pageInvoke(callerPagePath.toLower(), params); });
+        return result;
+    }
+
+    //! @brief 返回主题的编号, 主题不存在时创建
+    //! @note 频繁发布的主题可以预先取得编号, 之后以编号发布, 不再有任何字符串操作.
+    quint32 topicId(const QString& topic) {
+        auto it = m_topicIds.constFind(topic);
+        if (it != m_topicIds.constEnd())
+            return it.value();
+        quint32 id = quint32(m_topicNames.size());
+        m_topicIds.insert(topic, id);
+        m_topicNames.append(topic);
+        m_subscribers.append(QVector<Subscription>());
+        return id;
+    }
+
+    //! @brief 向订阅了主题的页面发布事件
+    //! @param topic 主题编号, 参见 topicId()
+    //! @param params 事件参数
+    //! @param subtree 只投递给该页面及其子孙页面, 为空时投递给所有订阅者
+    //! @return 收到 pageNotify() 的页面数
+    //! @note 按订阅的先后顺序投递, 不满足投递条件(参见 AbstractPage::NotifyFlag)的页面被跳过.
+    int publish(quint32 topic, const QVariantMap& params, const AbstractPage* subtree = nullptr) {
+        if (topic >= quint32(m_subscribers.size()))
+            return 0;
+
+        // 使用副本: pageNotify() 中可能订阅或退订. 前面的订阅者可能导致后面的页面被卸载、回收甚至销毁,
+        // 这些页面都已退订, 因此发生过退订时, 投递前先确认页面仍在订阅者中, 再访问页面.
+        const QVector<Subscription> subscribers = m_subscribers[int(topic)];
+        const QString& name = m_topicNames[int(topic)];
+        const quint64 unsubscribes = m_unsubscribes;
+        int count = 0;
+        for (const auto& subscription : subscribers) {
+            AbstractPage* page = subscription.page;
+            if (m_unsubscribes != unsubscribes) {
+                const auto& current = m_subscribers[int(topic)];
+                if (std::none_of(current.begin(), current.end(), [page](const Subscription& s) { return s.page == page; }))
+                    continue;
+            }
+            if (subtree && !isDescendant(page, subtree))
+                continue;
+            switch (page->m_state) {
+            case AbstractPage::Active:
+                break;
+            case AbstractPage::Constructed:
+                if (subscription.flags & AbstractPage::NotifyUninitialized)
+                    break;
+                continue;
+            case AbstractPage::Initialized:
+            case AbstractPage::Suspended:
+                if (subscription.flags & AbstractPage::NotifyInactive)
+                    break;
+                continue;
+            default:
+                continue;
+            }
+            traced(TraceNotify, page, [&] { page->pageNotify(name, params); });
+            ++count;
+        }
+        return count;
+    }
+
+    //! @brief 向订阅了主题的页面发布事件
+    //! @param subtreePath 只投递给该路径的页面及其子孙页面, 为空时投递给所有订阅者
+    //! @see publish(quint32, const QVariantMap&, const AbstractPage*)
+    int publish(const QString& topic, const QVariantMap& params, const QString& subtreePath = {}) {
+        auto it = m_topicIds.constFind(topic);
+        if (it == m_topicIds.constEnd())
+            return 0;
+        const AbstractPage* subtree = nullptr;
+        if (!subtreePath.isEmpty() && canonicalPath(subtreePath) != QLatin1String("/")) {
+            subtree = m_pathIndex.value(canonicalPath(subtreePath));
+            if (subtree == nullptr)
+                return 0;
+        }
+        return publish(it.value(), params, subtree);
+    }
+
+    //! @brief 返回主题的订阅者数量
+    int subscriberCount(const QString& topic) const {
+        auto it = m_topicIds.constFind(topic);
+        return it == m_topicIds.constEnd() ? 0 : m_subscribers[int(it.value())].size();
+    }
+
+    //! @brief 异步的页面调用方法, 线程安全
+    //! @param key 合并键, 不为空且目标页面启用了 AbstractPage::setCoalesceInvokes() 时, 
+    //!        积压的同键消息只保留最新的一条, 被合并掉的调用其 future 将被取消, 结果为空.
+    //! @return 调用结果的 future, 目标页面不存在时结果为空.
+    //! @note 可以在任何线程中调用(PagesManager 实例须已在GUI线程中创建). 消息进入无锁的多生产者队列,
+    //!       队列由GUI线程批量取出并调用 pageInvoke(), 每批的处理时间不超过 setInvokeBudget(), 
+    //!       未处理完的消息留到事件循环的下一次运行; 无论消息多少, 事件队列中最多只有一个待处理的事件.
+    QFuture<QVariant> pageInvokeAsync(QString callerPagePath, QString calleePagePath, QVariantMap params, QString key = {}) {
+        auto node = new InvokeNode();
+        node->invoke.caller = std::move(callerPagePath).toLower();
+        node->invoke.callee = canonicalPath(std::move(calleePagePath));
+        node->invoke.params = std::move(params);
+        node->invoke.key = std::move(key);
+        node->invoke.result.reportStarted();
+        QFuture<QVariant> future = node->invoke.result.future();
+
+        // 先链接节点, 再安排取出, 保证取出时能看到节点
+        InvokeNode* prev = m_invokeHead.fetchAndStoreOrdered(node);
+        prev->next.storeRelease(node);
+        m_invokeQueued.fetchAndAddRelaxed(1);
+        if (m_invokeScheduled.testAndSetOrdered(0, 1))
+            QMetaObject::invokeMethod(this, [this] { drainInvokes(); }, Qt::QueuedConnection);
+        return future;
+    }
+
+    //! @brief 设置每批处理异步调用的时间预算(毫秒), 默认 8 毫秒
+    //! @note 每批至少处理一条消息.
+    void setInvokeBudget(int ms) { m_invokeBudgetMs = qMax(0, ms); }
+
+    int invokeBudget() const { return m_invokeBudgetMs; }
+
+    //! @brief 返回异步调用统计
+    InvokeStats invokeStats() const {
+        InvokeStats stats = m_invokeStats;
+        stats.pending = m_invokeQueued.loadRelaxed() + m_invokeBacklog.size();
+        return stats;
+    }
+
+    //! @brief 将正常页面路径转换为短码路径
+    //! @param normalPath 正常页面路径, 格式: /page1/page2/page3
+    //! @return 短码路径, 格式: p1p2p3 (每个页面的短码连接, 无分隔符), 某一级没有短码时返回空字符串
+    QString toShortcodePath(QString normalPath) const {
+        if (normalPath.isEmpty())
+            return {};
+
+        // 已安装的页面直接使用其缓存的短码路径, 页面池中的页面没有唯一的短码路径
+        normalPath = canonicalPath(std::move(normalPath));
+        if (auto page = m_pathIndex.value(normalPath))
+            return isPooled(page) ? QString() : page->shortcodePath();
+
+        // 尚未构造的延迟页面: 沿页面树逐级查找, 使用各级容器所属作用域的短码
+        QString result;
+        AbstractPage* parent = nullptr;
+        bool inTree = m_root != nullptr;
+
+        for (const auto& hop : normalPath.split('/', Qt::SkipEmptyParts)) {
+            QString code;
+            AbstractPage* page = nullptr;
+            bool found = inTree && lookupHop(parent, [&](PagesContainer* container) {
+                auto it = container->m_names.constFind(hop);
+                if (it == container->m_names.constEnd())
+                    return false;
+                code = container->shortcodes().pageCode(hop);
+                page = qobject_cast<AbstractPage*>(container->widget(it.value()));
+                return true;
+            });
+
+            // 延迟页面之下以及页面树之外的部分按全局作用域编码
+            inTree = found && (parent = page) != nullptr;
+            if (!found)
+                code = ShortcodeAllocator::instance().pageCode(hop);
+            if (code.isEmpty())
+                return {};
+            result += code;
+        }
+        
+        return result;
+    }
+
+    //! @brief 将短码路径转换为正常页面路径
+    //! @param shortcodePath 短码路径, 格式: p1p2p3 (短码长度由首字符决定, 参见 ShortcodeAllocator)
+    //! @return 正常页面路径, 格式: /page1/page2/page3, 转换失败返回空字符串
+    //! @note 沿页面树逐级解码, 每一级只在上一级页面的容器中查找, 因此局部作用域的短码不会产生歧义.
+    //! @note 兼容旧版本固定两字符一组的短码路径: 其中手写的大写短码按现在的字母表会被当作三字符短码的首字符,
+    //!       解码失败时将按两字符一组再解码一次.
+    QString fromShortcodePath(QStringView shortcodePath) const {
+        QString result = decodeShortcodePath(shortcodePath, false);
+        auto upper = [](QChar c) { return c.unicode() >= 'A' && c.unicode() <= 'Z'; };
+        if (result.isEmpty() && shortcodePath.size() % 2 == 0 
+            && std::any_of(shortcodePath.begin(), shortcodePath.end(), upper))
+            result = decodeShortcodePath(shortcodePath, true);
+        return result;
+    }
+
+    //! @brief 返回页面路径对应的路由标识
+    //! @return 路由标识, 路径无法转换为短码路径、超出 RouteId::MaxLength 或位于页面池中时返回空路由
+    RouteId routeId(QString normalPath) const {
+        normalPath = canonicalPath(std::move(normalPath));
+        // 与 toShortcodePath() 相同, 页面池中的页面没有唯一的路由
+        if (auto page = m_pathIndex.value(normalPath))
+            return isPooled(page) ? RouteId() : RouteId::fromShortcodePath(page->shortcodePath());
+        return RouteId::fromShortcodePath(toShortcodePath(normalPath));
+    }
+
+    //! @brief 返回路由标识对应的页面路径
+    //! @return 规范的页面路径, 转换失败返回空字符串
+    //! @note 已安装的页面仅需一次哈希查找, 并返回页面缓存的路径, 不产生内存分配.
+    QString routePath(RouteId id) const {
+        if (auto page = m_routeIndex.value(id))
+            return page->pagePath();
+        QChar buffer[RouteId::MaxLength];
+        return fromShortcodePath(QStringView(buffer, id.toChars(buffer)));
+    }
+
+    //! @brief 批量转换页面路径为路由标识, 用于转换日志等大量数据
+    QVector<RouteId> routeIds(const QStringList& normalPaths) const {
+        QVector<RouteId> result;
+        result.reserve(normalPaths.size());
+        for (const auto& path : normalPaths)
+            result.append(routeId(path));
+        return result;
+    }
+
+    //! @brief 批量转换路由标识为页面路径, 相同的未安装路由只解码一次
+    QStringList routePaths(const QVector<RouteId>& ids) const {
+        QStringList result;
+        QHash<RouteId, QString> decoded;
+        result.reserve(ids.size());
+        for (const auto& id : ids) {
+            if (auto page = m_routeIndex.value(id)) {
+                result.append(page->pagePath());
+                continue;
+            }
+            auto it = decoded.constFind(id);
+            if (it == decoded.constEnd())
+                it = decoded.insert(id, routePath(id));
+            result.append(it.value());
+        }
+        return result;
+    }
+
+    //! @brief 返回指定路由的页面实例
+    //! @see page(QString)
+    AbstractPage* page(RouteId id) const {
+        QString path = routePath(id);
+        return path.isEmpty() ? nullptr : page(std::move(path));
+    }
+
+    //! @brief 以路由标识指定目标页面的 pageSwitch()
+    void pageSwitch(QString callerPagePath, RouteId callee, QVariantMap params) {
+        QString path = routePath(callee);
+        Q_ASSERT_X(!path.isEmpty(), "PagesManager::pageSwitch", "unknown route");
+        if (!path.isEmpty())
+            pageSwitch(std::move(callerPagePath), std::move(path), std::move(params));
+    }
+
+    //! @brief 以路由标识指定目标页面的 pageGoto()
+    void pageGoto(QString callerPagePath, RouteId callee, QVariantMap params) {
+        QString path = routePath(callee);
+        Q_ASSERT_X(!path.isEmpty(), "PagesManager::pageGoto", "unknown route");
+        if (!path.isEmpty())
+            pageGoto(std::move(callerPagePath), std::move(path), std::move(params));
+    }
+
+public:
+    //! @brief 当前以任何方式切换当前页面时, 将发射此信号。
+    Q_SIGNAL void currentPageChanged(QString oldPagePath, QString newPagePath);
+
+    //! @brief 页面因超出内存预算被回收后, 将发射此信号。
+    //! @note 随之回收的子、孙页面不单独发射.
+    Q_SIGNAL void pageEvicted(QString pagePath);
+
+    //! @brief 页面异步准备完成并且 pagePrepared() 返回后, 将发射此信号。
+    Q_SIGNAL void pageReady(QString pagePath);
+
+    //! @brief 页面(连同其子孙页面)被安装到页面树中, 或者延迟页面被构造后, 将发射此信号。
+    //! @note 只有存在连接时才会计算路径并发射.
+    Q_SIGNAL void pageInstalled(QString pagePath);
+
+    //! @brief 设置根容器后, 将发射此信号。
+    Q_SIGNAL void rootContainerChanged();
+
+    //! @brief 页面(连同其子孙页面)被卸载后, 将发射此信号。
+    Q_SIGNAL void pageUninstalled(QString pagePath);
+
+protected:
+    typedef QVarLengthArray<AbstractPage*, 16> PageHops;
+
+    //! @brief 将路径规范化为索引使用的形式: 小写, 以 / 开头, 不以 / 结尾, 无空段.
+    //! @note 输入已是规范形式时直接返回, 不产生内存分配.
+    static QString canonicalPath(QString path) {
+        path = std::move(path).toLower();
+        if (path.startsWith('/') && !path.endsWith('/') && !path.contains(QLatin1String("//")))
+            return path;
+        return "/" + path.split('/', Qt::SkipEmptyParts).join('/');
+    }
+
+    //! @brief 沿页面树逐级访问规范路径上的每一跳, 不构造延迟页面
+    //! @param fn 形如 void(PagesContainer* container, const QString& name, int hop) 的可调用对象
+    //! @return 路径是否存在; 路径经过尚未构造的延迟页面(或未绑定的页面池路由)时, 其下的部分无法确认, 视为存在
+    template<class Fn>
+    bool visitHops(const QString& path, Fn fn) const {
+        if (auto page = m_pathIndex.value(path)) {
+            PageHops hops;
+            collectHops(page, hops);
+            for (int i = 0; i < hops.size(); ++i)
+                fn(hops[i]->m_parent, hops[i]->m_name, i);
+            return true;
+        }
+
+        AbstractPage* parent = nullptr;
+        int i = 0;
+        for (const auto& hop : path.split('/', Qt::SkipEmptyParts)) {
+            AbstractPage* page = nullptr;
+            bool found = lookupHop(parent, [&](PagesContainer* container) {
+                auto it = container->m_names.constFind(hop);
+                if (it == container->m_names.constEnd()) {
+                    page = container->pooledPage(hop);
+                    if (!page && !container->poolOf(hop))
+                        return false;
+                }
+                else
+                    page = qobject_cast<AbstractPage*>(container->widget(it.value()));
+                fn(container, hop, i++);
+                return true;
+            });
+            if (!found)
+                return false;
+            if (page == nullptr)
+                return true;
+            parent = page;
+        }
+        return parent != nullptr;
+    }
+
+    //! @brief 将查询参数的值转换为声明的类型, 失败时返回无效的 QVariant
+    static QVariant convertParam(QStringView value, int type) {
+        // 只有包含转义字符时才解码
+        QString decoded;
+        if (value.contains('%') || value.contains('+')) {
+            QByteArray bytes = value.toUtf8();
+            bytes.replace('+', ' ');
+            decoded = QUrl::fromPercentEncoding(bytes);
+            value = decoded;
+        }
+
+        bool ok = true;
+        QVariant result;
+        switch (type) {
+        case QMetaType::QString:
+            return value.toString();
+        case QMetaType::Int:
+            result = QLocale::c().toInt(value, &ok);
+            break;
+        case QMetaType::UInt:
+            result = QLocale::c().toUInt(value, &ok);
+            break;
+        case QMetaType::LongLong:
+            result = QLocale::c().toLongLong(value, &ok);
+            break;
+        case QMetaType::ULongLong:
+            result = QLocale::c().toULongLong(value, &ok);
+            break;
+        case QMetaType::Double:
+            result = QLocale::c().toDouble(value, &ok);
+            break;
+        case QMetaType::Bool:
+            ok = value == QLatin1String("1") || value == QLatin1String("true") 
+                || value == QLatin1String("0") || value == QLatin1String("false");
+            result = value == QLatin1String("1") || value == QLatin1String("true");
+            break;
+        default:
+            result = value.toString();
+            ok = result.convert(type);
+            break;
+        }
+        return ok ? result : QVariant();
+    }
+
+    //! @brief 解析深度链接, 参见 parseLink(QStringView)
+    //! @param params 为空时只校验, 不构建参数表
+    //! @param verified 写入路径是否已确认存在, 参见 Link::verified
+    //! @return 链接是否有效
+    bool parseLink(QStringView link, QString* path, QVariantMap* params, QString* error, bool* verified) const {
+        error->clear();
+        *verified = true;
+        int end = int(link.indexOf('#'));
+        if (end >= 0)
+            link = link.left(end);
+        int mark = int(link.indexOf('?'));
+        QStringView route = mark < 0 ? link : link.left(mark);
+        QStringView query = mark < 0 ? QStringView() : link.mid(mark + 1);
+
+        if (m_root == nullptr || route.isEmpty()) {
+            *error = QString("empty link");
+            return false;
+        }
+        *path = route.startsWith('/') ? canonicalPath(route.toString()) : fromShortcodePath(route);
+        if (path->isEmpty()) {
+            *error = QString("unknown shortcode path: %1").arg(route.toString());
+            return false;
+        }
+
+        // 路径上每一跳的名称(指向 path 的视图)与参数声明
+        QStringView canonical(*path);
+        QVarLengthArray<QStringView, 16> hops;
+        for (int from = 1; from <= canonical.size(); ) {
+            int to = int(canonical.indexOf('/', from));
+            if (to < 0)
+                to = int(canonical.size());
+            hops.append(canonical.mid(from, to - from));
+            from = to + 1;
+        }
+        QVarLengthArray<const PageParamSchema*, 16> schemas(hops.size());
+        std::fill(schemas.begin(), schemas.end(), nullptr);
+        int visited = 0;
+        bool exists = visitHops(*path, [&](PagesContainer* container, const QString& name, int hop) {
+            if (hop < schemas.size())
+                schemas[hop] = container->paramSchema(name);
+            visited = hop + 1;
+        });
+        if (!exists || hops.isEmpty()) {
+            *error = QString("no such page: %1").arg(*path);
+            return false;
+        }
+        *verified = visited == hops.size();
+
+        // 逐个解析 key=value, 记录每一跳已提供的声明参数(位图)
+        const int target = hops.size() - 1;
+        QVarLengthArray<quint64, 16> seen(hops.size());
+        std::fill(seen.begin(), seen.end(), 0);
+        QVarLengthArray<QVariantMap, 16> hopParams(params ? hops.size() : 0);
+
+        for (int from = 0; from < query.size(); ) {
+            int to = int(query.indexOf('&', from));
+            if (to < 0)
+                to = int(query.size());
+            QStringView pair = query.mid(from, to - from);
+            from = to + 1;
+            if (pair.isEmpty())
+                continue;
+
+            int eq = int(pair.indexOf('='));
+            QStringView key = eq < 0 ? pair : pair.left(eq);
+            QStringView value = eq < 0 ? QStringView() : pair.mid(eq + 1);
+
+            int hop = target;
+            int dot = int(key.indexOf('.'));
+            if (dot > 0) {
+                for (int h = 0; h < hops.size(); ++h) {
+                    if (hops[h] == key.left(dot)) {
+                        hop = h;
+                        key = key.mid(dot + 1);
+                        break;
+                    }
+                }
+            }
+
+            int type = QMetaType::QString;
+            const PageParamSchema* schema = schemas[hop];
+            if (schema && !schema->isEmpty()) {
+                int index = 0;
+                while (index < schema->size() && QStringView(schema->at(index).key) != key)
+                    ++index;
+                if (index == schema->size()) {
+                    *error = QString("unknown parameter: %1").arg(pair.toString());
+                    return false;
+                }
+                type = schema->at(index).type;
+                seen[hop] |= quint64(1) << index;
+            }
+
+            if (params == nullptr && type == QMetaType::QString)
+                continue;
+            QVariant converted = convertParam(value, type);
+            if (!converted.isValid()) {
+                *error = QString("invalid value for %1: expected %2").arg(pair.toString(), QMetaType::typeName(type));
+                return false;
+            }
+            if (params)
+                hopParams[hop].insert(key.toString(), std::move(converted));
+        }
+
+        for (int h = 0; h < hops.size(); ++h) {
+            if (schemas[h] == nullptr)
+                continue;
+            for (int k = 0; k < schemas[h]->size(); ++k) {
+                if (schemas[h]->at(k).required && !(seen[h] & (quint64(1) << k))) {
+                    *error = QString("missing parameter: %1").arg(schemas[h]->at(k).key);
+                    return false;
+                }
+            }
+        }
+
+        // 目标页面的参数在顶层, 上级页面的参数以其路径为键
+        if (params) {
+            *params = std::move(hopParams[target]);
+            for (int h = 0; h < target; ++h)
+                if (!hopParams[h].isEmpty())
+                    params->insert(path->left(int(hops[h].end() - path->constData())), hopParams[h]);
+        }
+        return true;
+    }
+
+    //! @brief 在 parent 的容器中依次调用 fn, 直到其返回 true
+    //! @note parent 为空时只查找 root 容器, 用于短码路径的逐级编码与解码.
+    template<class Fn>
+    bool lookupHop(AbstractPage* parent, Fn fn) const {
+        if (parent == nullptr)
+            return fn(m_root);
+        for (auto container : parent->m_containers)
+            if (fn(container))
+                return true;
+        return false;
+    }
+
+    //! @brief 根据规范路径查找页面
+    //! @note 索引未命中时路径可能指向尚未构造的延迟页面, 此时逐级查找并构造沿途的页面.
+    AbstractPage* resolvePage(const QString& path) const {
+        if (auto page = m_pathIndex.value(path))
+            return page;
+
+        AbstractPage* page = nullptr;
+        for (const auto& n : path.split('/', Qt::SkipEmptyParts)) {
+            page = page ? page->subpage(n) : m_root->page(n);
+            if (page == nullptr)
+                return nullptr;
+        }
+        return page;
+    }
+
+    //! @brief 收集从顶级页面到 page 的每一跳, 顺序为 root -> page.
+    static void collectHops(AbstractPage* page, PageHops& hops);
+
+    //! @brief 如果页面未经过初始化, 则触发 pageLazyInit() 事件.
+    static void lazyInit(AbstractPage* page);
+
+    //! @brief 页面被访问时, 先应用会话快照中的参数, 再触发 pageLazyInit() 事件.
+    void initPage(AbstractPage* page) {
+        applySessionParams(page);
+        lazyInit(page);
+    }
+
+    //! @brief 容器是否已经挂载到 root 容器之下
+    bool isAttached(const PagesContainer* container) const;
+
+    //! @brief 将页面及其所有子、孙页面登记到路径索引
+    //! @note 页面所在的容器尚未挂载到 root 之下时不做任何事, 等到容器被挂载时再统一登记.
+    void indexPage(AbstractPage* page);
+
+    //! @brief 将容器中的所有页面(包括下层页面)登记到路径索引
+    void indexContainer(PagesContainer* container);
+
+    //! @brief 将页面及其子、孙页面从路径索引中移除, 并保留它们的 m_lastParams
+    //! @param detach 为 false 时页面实例继续使用(页面池重新绑定数据键), 只移除路径并换出 m_lastParams, 保留订阅等状态
+    void unindexPage(AbstractPage* page, bool detach = true);
+
+    //! @brief 容器卸载名为 names 的页面之前调用, 将这些页面(连同子、孙页面)从索引、历史与缓存中移除
+    void uninstallPages(PagesContainer* container, const QSet<QString>& names);
+
+    //! @brief 结束页面及其子、孙页面的准备任务, 并将它们从索引、订阅与当前页面等记录中移除
+    //! @note 页面被直接销毁(而不是卸载)时调用, 此时子树仍然完整.
+    void forgetPages(AbstractPage* page);
+
+    //! @brief 页面析构时调用, 参见 AbstractPage::~AbstractPage()
+    void pageDestroyed(AbstractPage* page);
+
+    //! @brief 挂载在页面树中的容器(或 root)析构时调用, 注销其中的页面
+    void containerDestroyed(PagesContainer* container);
+
+    //! @brief 页面或其祖先是否属于页面池, 这些页面的短码路径不唯一, 不登记到 RouteId 索引
+    static bool isPooled(const AbstractPage* page) {
+        for (auto p = page; p; p = p->parentPage())
+            if (!p->m_poolKey.isNull())
+                return true;
+        return false;
+    }
+
+    //! @brief 单例的存储位置, 实例销毁时被置空
+    //! @note 准备任务在工作线程中读取, 因此使用原子指针.
+    static QAtomicPointer<PagesManager>& instancePointer() {
+        static QAtomicPointer<PagesManager> __imp;
+        return __imp;
+    }
+
+    //! @brief 回收前触发页面及其已构造的子、孙页面的 pageEvict() 事件并标记为 Evicted, 子页面先于父页面
+    //! @note 须在 unindexPage() 之前调用, 以便 pageEvict() 中写入 m_lastParams 的状态被保留.
+    void evictPages(AbstractPage* page) {
+        for (auto c : page->m_containers)
+            c->visitCreated([this](AbstractPage* p) { evictPages(p); });
+        traced(TraceEvict, page, [page] { page->pageEvict(); });
+        page->m_state = AbstractPage::Evicted;
+        m_evictedIds.insert(pathId(page->pagePath()));
+    }
+
+    //! @brief 丢弃页面被推迟且尚未执行的更新
+    void discardUpdates(AbstractPage* page) {
+        if (page->m_deferredUpdates.isEmpty())
+            return;
+        m_updateStats.discarded += page->m_deferredUpdates.size();
+        page->m_deferredUpdates.clear();
+        m_deferredPages.remove(page);
+        page->removeEventFilter(this);
+    }
+
+    //! @brief 抓取页面当前的外观存入快照缓存
+    void grabSnapshot(AbstractPage* page) {
+        if (!page->m_snapshotEnabled || !page->isVisible())
+            return;
+        QPixmap pixmap = page->grab();
+        if (pixmap.isNull())
+            return;
+        qint64 bytes = qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+        m_snapshots.insert(pathId(page->pagePath()), new QPixmap(std::move(pixmap)), int(qMax<qint64>(1, bytes / 1024)));
+    }
+
+    //! @brief 在页面所在容器的位置上显示页面的快照, 直到 hideSnapshot()
+    void showSnapshot(AbstractPage* page) {
+        if (!page->m_snapshotEnabled || !m_root->isVisible())
+            return;
+        QPixmap* pixmap = m_snapshots.object(pathId(page->pagePath()));
+        if (pixmap == nullptr) {
+            ++m_snapshotStats.misses;
+            return;
+        }
+        ++m_snapshotStats.hits;
+
+        // 叠加在 root 容器之上, 同步绘制使其在页面切换的耗时之前就显示出来
+        auto overlay = new QLabel(m_root);
+        overlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+        overlay->setScaledContents(true);
+        overlay->setPixmap(*pixmap);
+        overlay->setGeometry(QRect(page->m_parent->mapTo(m_root, QPoint(0, 0)), page->m_parent->size()));
+        overlay->show();
+        overlay->raise();
+        overlay->repaint();
+        m_snapshotOverlay = overlay;
+        m_snapshotTarget = page;
+    }
+
+    //! @brief 移除正在显示的快照
+    void hideSnapshot() {
+        if (m_snapshotOverlay) {
+            m_snapshotOverlay->hide();
+            m_snapshotOverlay->deleteLater();
+        }
+        m_snapshotOverlay = nullptr;
+        m_snapshotTarget = nullptr;
+    }
+
+    //! @brief 为页面池的路由 name 绑定一个实例
+    //! @note 池未满时构造新实例, 否则重新绑定最久未使用且不在当前路径上的实例; 
+    //!       所有实例都在当前路径上时临时超出容量, 由 trimPools() 收回.
+    AbstractPage* acquirePooled(PagesContainer* container, PagesContainer::PagePool& pool, const QString& name);
+
+    //! @brief 销毁超出容量的页面池中最久未使用且不在当前路径上的实例, 直到回到容量之内
+    //! @note 在每次导航结束时(enforcePageBudget() 中)调用, 仍然无法收回的池留待下一次.
+    void trimPools();
+
+    template<class Visitor>
+    static void visitContainer(const PagesContainer* container, Visitor& visitor, int depth) {
+        for (auto it = container->begin(); it != container->end(); ++it) {
+            AbstractPage* page = it.page();
+            if (visitor(it.name(), page, depth) && page)
+                for (auto c : page->m_containers)
+                    visitContainer(c, visitor, depth + 1);
+        }
+    }
+
+    //! @brief 容器中名为 name 的页面已可以从页面树中访问, 发射 pageInstalled()
+    void pageAttached(const PagesContainer* container, const QString& name) {
+        static const QMetaMethod signal = QMetaMethod::fromSignal(&PagesManager::pageInstalled);
+        if (!isSignalConnected(signal) || !isAttached(container))
+            return;
+        auto parent = container->parentPage();
+        emit pageInstalled((parent ? parent->pagePath() : QString()) + "/" + name);
+    }
+
+    //! @brief 延迟页面由工厂构造完成
+    void pageCreated(AbstractPage* page) {
+        page->m_lastUsed = ++m_useClock;
+        m_factoryPages.insert(page);
+    }
+
+    typedef QContiguousCache<HistoryEntry> History;
+
+    //! @brief 合并导航中尚未处理的切换请求
+    struct PendingSwitch
+    {
+        QString     caller;
+        QString     callee;
+        QVariantMap params;
+    };
+
+    //! @brief 将页面压入历史, 按 historyPolicy() 合并重复记录, 超出容量时丢弃最旧的记录
+    void pushHistory(History& history, const QString& path) {
+        HistoryEntry entry{ pathId(path), {} };
+        if (m_historySnapshots)
+            if (auto page = m_pathIndex.value(m_idPaths[int(entry.pageId)]))
+                entry.params = page->m_lastParams;
+
+        if (m_historyPolicy == CollapseConsecutive && !history.isEmpty() && history.last() == entry)
+            return;
+        history.append(entry);
+        if (!history.areIndexesValid())
+            history.normalizeIndexes();
+    }
+
+    //! @brief 追踪事件的环形缓冲区槽位
+    //! @note 写入者通过原子递增的 m_traceHead 领取槽位, 写入完成后将 seq 置为 序号+1,
+    //!       读取者据此跳过正在写入或已被覆盖的槽位, 因此无需加锁.
+    struct TraceSlot
+    {
+        QAtomicInteger<quint64> seq;
+        quint32 pageId = 0;
+        quint32 hook = 0;
+        qint64  start = 0;
+        qint64  duration = 0;
+    };
+
+    //! @brief 调用 fn, 启用追踪时记录其耗时
+    template<class Fn>
+    void traced(TraceHook hook, const AbstractPage* page, Fn&& fn) {
+        if (Q_LIKELY(!m_tracing)) {
+            fn();
+            return;
+        }
+        qint64 start = m_traceClock.nsecsElapsed();
+        fn();
+        traceRecord(hook, page, start);
+    }
+
+    //! @brief 将一个从 start 开始、到现在结束的事件写入环形缓冲区
+    void traceRecord(TraceHook hook, const AbstractPage* page, qint64 start) {
+        qint64 end = m_traceClock.nsecsElapsed();
+        quint64 index = m_traceHead.fetchAndAddRelaxed(1);
+        TraceSlot& slot = m_traceSlots[index & m_traceMask];
+        slot.seq.storeRelaxed(0);
+        slot.pageId = pathId(page->pagePath());
+        slot.hook = hook;
+        slot.start = start;
+        slot.duration = end - start;
+        slot.seq.storeRelease(index + 1);
+    }
+
+    //! @brief 按时间顺序访问环形缓冲区中完整的追踪事件
+    template<class Fn>
+    void visitTrace(Fn&& fn) const {
+        if (m_traceSlots.isNull())
+            return;
+        quint64 head = m_traceHead.loadAcquire();
+        quint64 first = head > m_traceMask + 1 ? head - m_traceMask - 1 : 0;
+        for (quint64 i = first; i < head; ++i) {
+            const TraceSlot& slot = m_traceSlots[i & m_traceMask];
+            if (slot.seq.loadAcquire() != i + 1)
+                continue;
+            TraceSlot copy;
+            copy.pageId = slot.pageId;
+            copy.hook = slot.hook;
+            copy.start = slot.start;
+            copy.duration = slot.duration;
+            if (slot.seq.loadAcquire() == i + 1)
+                fn(copy);
+        }
+    }
+
+    //! @brief 记录一次导航调用, 嵌套的调用(例如 pageGoto() 内部的 pageSwitch())不会重复记录
+    struct RecordScope
+    {
+        RecordScope(PagesManager* manager, NavigationCall call, 
+            const QString& caller, const QString& callee, const QVariantMap& params)
+            : manager(manager)
+            , active(manager->m_recordDepth++ == 0 && manager->m_recorder)
+        {
+            if (active) {
+                this->call = call;
+                this->caller = caller;
+                this->callee = callee;
+                this->params = params;
+                start = manager->m_recordClock.nsecsElapsed();
+            }
+        }
+
+        ~RecordScope() {
+            --manager->m_recordDepth;
+            if (active && manager->m_recorder)
+                manager->writeRecord(call, start, manager->m_recordClock.nsecsElapsed() - start, caller, callee, params);
+        }
+
+        PagesManager*   manager;
+        bool            active;
+        NavigationCall  call = CallSwitch;
+        qint64          start = 0;
+        QString         caller;
+        QString         callee;
+        QVariantMap     params;
+    };
+
+    //! @brief 写入一条导航记录
+    void writeRecord(NavigationCall call, qint64 start, qint64 duration, 
+        const QString& caller, const QString& callee, const QVariantMap& params) 
+    {
+        quint32 callerId = recordString(caller.toLower());
+        quint32 calleeId = recordString(callee.isEmpty() ? callee : canonicalPath(callee));
+        *m_recorder << quint8(call) << start << duration << callerId << calleeId << streamableParams(params);
+    }
+
+    //! @brief 返回参数中可以通过 QDataStream 序列化的部分, 无法序列化的值(例如 PageParam)被剔除
+    //! @note 嵌套的 QVariantMap / QVariantHash / QVariantList 逐项过滤.
+    static QVariantMap streamableParams(const QVariantMap& params) {
+        QVariantMap result;
+        QVariant value;
+        for (auto it = params.constBegin(); it != params.constEnd(); ++it)
+            if (streamableValue(it.value(), &value))
+                result.insert(it.key(), value);
+        return result;
+    }
+
+    //! @brief 过滤单个参数值
+    //! @return 值无法序列化时返回 false, 否则将过滤后的值写入 out
+    static bool streamableValue(const QVariant& value, QVariant* out) {
+        int type = value.userType();
+        if (type == QMetaType::QVariantMap) {
+            *out = streamableParams(value.toMap());
+            return true;
+        }
+        if (type == QMetaType::QVariantHash) {
+            QVariantHash hash;
+            QVariant item;
+            const QVariantHash source = value.toHash();
+            for (auto it = source.constBegin(); it != source.constEnd(); ++it)
+                if (streamableValue(it.value(), &item))
+                    hash.insert(it.key(), item);
+            *out = hash;
+            return true;
+        }
+        if (type == QMetaType::QVariantList) {
+            QVariantList list;
+            QVariant item;
+            for (const auto& v : value.toList())
+                if (streamableValue(v, &item))
+                    list.append(item);
+            *out = list;
+            return true;
+        }
+        if (type == QMetaType::VoidStar || type == QMetaType::QObjectStar)
+            return false;
+        if (type >= QMetaType::User) {
+            // 自定义类型只有注册了流操作符才能序列化, 试写一次即可判断
+            QByteArray scratch;
+            QDataStream probe(&scratch, QIODevice::WriteOnly);
+            if (!QMetaType::save(probe, type, value.constData()))
+                return false;
+        }
+        *out = value;
+        return true;
+    }
+
+    //! @brief 返回字符串在导航记录中的编号, 首次出现时写入定义
+    quint32 recordString(const QString& text) {
+        auto it = m_recordStrings.constFind(text);
+        if (it != m_recordStrings.constEnd())
+            return it.value();
+        quint32 id = quint32(m_recordStrings.size());
+        m_recordStrings.insert(text, id);
+        *m_recorder << RecordString << id << text;
+        return id;
+    }
+
+    //! @brief 逐级解码短码路径
+    //! @param legacy 是否按旧版本的格式固定两字符一组分割, 否则短码长度由首字符决定
+    QString decodeShortcodePath(QStringView shortcodePath, bool legacy) const {
+        if (shortcodePath.isEmpty())
+            return {};
+
+        QString result;
+        result.reserve(shortcodePath.size() * 4);
+        AbstractPage* parent = nullptr;
+        bool inTree = m_root != nullptr;
+
+        for (int i = 0; i < shortcodePath.size(); ) {
+            int length = legacy ? 2 : ShortcodeAllocator::codeLength(shortcodePath[i]);
+            if (length == 0 || i + length > shortcodePath.size())
+                return {};  // 短码非法或不完整
+            QStringView code = shortcodePath.mid(i, length);
+            i += length;
+
+            QString name;
+            AbstractPage* page = nullptr;
+            bool found = inTree && lookupHop(parent, [&](PagesContainer* container) {
+                QString n = container->shortcodes().pageName(code);
+                auto it = container->m_names.constFind(n);
+                if (n.isEmpty() || it == container->m_names.constEnd())
+                    return false;
+                name = n;
+                page = qobject_cast<AbstractPage*>(container->widget(it.value()));
+                return true;
+            });
+
+            // 延迟页面之下以及页面树之外的部分按全局作用域解码
+            inTree = found && (parent = page) != nullptr;
+            if (!found)
+                name = ShortcodeAllocator::instance().pageName(code);
+            if (name.isEmpty())
+                return {};  // 短码不存在
+
+            result += '/';
+            result += name;
+        }
+        
+        return result;
+    }
+
+    //! @brief page 是否为 ancestor 或其子孙页面
+    static bool isDescendant(const AbstractPage* page, const AbstractPage* ancestor) {
+        for (auto p = page; p; p = p->parentPage())
+            if (p == ancestor)
+                return true;
+        return false;
+    }
+
+    //! @brief 登记页面对主题的订阅
+    void subscribe(AbstractPage* page, const QString& topic, AbstractPage::NotifyFlags flags) {
+        quint32 id = topicId(topic);
+        auto& subscribers = m_subscribers[int(id)];
+        for (auto& subscription : subscribers) {
+            if (subscription.page == page) {
+                subscription.flags = flags;
+                return;
+            }
+        }
+        subscribers.append(Subscription{ page, flags });
+        page->m_topics.append(id);
+    }
+
+    //! @brief 取消页面对主题的订阅
+    void unsubscribe(AbstractPage* page, quint32 topic) {
+        auto& subscribers = m_subscribers[int(topic)];
+        for (int i = 0; i < subscribers.size(); ++i) {
+            if (subscribers[i].page == page) {
+                subscribers.remove(i);
+                break;
+            }
+        }
+        page->m_topics.removeOne(topic);
+        ++m_unsubscribes;
+    }
+
+    //! @brief 取消页面的全部订阅
+    void unsubscribeAll(AbstractPage* page) {
+        while (!page->m_topics.isEmpty())
+            unsubscribe(page, page->m_topics.last());
+    }
+
+    //! @brief 等待交付的异步调用
+    struct PendingInvoke
+    {
+        QString     caller;
+        QString     callee;
+        QVariantMap params;
+        QString     key;
+        QFutureInterface<QVariant> result;
+        bool        superseded = false;
+    };
+
+    //! @brief 异步调用队列的节点 (侵入式的多生产者单消费者队列)
+    struct InvokeNode
+    {
+        QAtomicPointer<InvokeNode> next;
+        PendingInvoke invoke;
+    };
+
+    //! @brief 取出队首的节点, 队列为空时返回空指针
+    //! @note 只能在GUI线程中调用. 返回的节点成为新的哨兵, 调用者应立即取走其中的数据.
+    InvokeNode* popInvoke() {
+        InvokeNode* tail = m_invokeTail;
+        InvokeNode* next = tail->next.loadAcquire();
+        if (next == nullptr)
+            return nullptr;
+        m_invokeTail = next;
+        delete tail;
+        return next;
+    }
+
+    //! @brief 放弃一次异步调用: 结果为空, future 被取消并结束, 等待结果的一方不会被阻塞
+    static void abandonInvoke(QFutureInterface<QVariant>& result) {
+        result.reportResult(QVariant());
+        result.cancel();
+        result.reportFinished();
+    }
+
+    //! @brief 在GUI线程中批量交付异步调用
+    void drainInvokes() {
+        m_invokeScheduled.fetchAndStoreOrdered(0);
+        while (InvokeNode* node = popInvoke()) {
+            m_invokeQueued.fetchAndAddRelaxed(-1);
+            m_invokeBacklog.append(std::move(node->invoke));
+        }
+        coalesceInvokes();
+
+        // pageInvoke() 中的嵌套事件循环可能重入本函数并修改 m_invokeBacklog, 因此本批消息先移到局部,
+        // 每条消息在交付之前按值取出
+        QVector<PendingInvoke> batch;
+        batch.swap(m_invokeBacklog);
+
+        QElapsedTimer timer;
+        timer.start();
+        int done = 0;
+        while (done < batch.size() && (done == 0 || timer.elapsed() < m_invokeBudgetMs)) {
+            PendingInvoke invoke = std::move(batch[done++]);
+            // hasPage() 对尚未构造的延迟页面之下的路径同样返回 true, 因此以 page() 的结果为准
+            QVariant result;
+            if (page(invoke.callee))
+                result = pageInvoke(invoke.caller, invoke.callee, invoke.params);
+            invoke.result.reportResult(result);
+            invoke.result.reportFinished();
+            ++m_invokeStats.delivered;
+        }
+
+        // 超出时间预算的消息放回队首, 重入期间新取出的消息排在其后
+        if (done < batch.size()) {
+            batch.remove(0, done);
+            for (auto& invoke : m_invokeBacklog)
+                batch.append(std::move(invoke));
+            m_invokeBacklog.swap(batch);
+        }
+
+        if (!m_invokeBacklog.isEmpty() && m_invokeScheduled.testAndSetOrdered(0, 1))
+            QMetaObject::invokeMethod(this, [this] { drainInvokes(); }, Qt::QueuedConnection);
+    }
+
+    //! @brief 合并积压的异步调用, 对启用了合并的页面, 相同合并键的消息只保留最新的一条
+    void coalesceInvokes() {
+        QSet<QPair<QString, QString>> seen;
+        bool superseded = false;
+        for (int i = m_invokeBacklog.size() - 1; i >= 0; --i) {
+            PendingInvoke& invoke = m_invokeBacklog[i];
+            if (invoke.key.isEmpty())
+                continue;
+            auto page = m_pathIndex.value(invoke.callee);
+            if (page == nullptr || !page->m_coalesceInvokes)
+                continue;
+
+            auto key = qMakePair(invoke.callee, invoke.key);
+            if (seen.contains(key)) {
+                invoke.superseded = superseded = true;
+                abandonInvoke(invoke.result);
+                ++m_invokeStats.coalesced;
+            }
+            else
+                seen.insert(key);
+        }
+
+        if (superseded) {
+            auto end = std::remove_if(m_invokeBacklog.begin(), m_invokeBacklog.end(), 
+                [](const PendingInvoke& invoke) { return invoke.superseded; });
+            m_invokeBacklog.erase(end, m_invokeBacklog.end());
+        }
+    }
+
+    static const quint32 NoPathId = 0xFFFFFFFF;     //!< 会话快照中表示没有当前页面
+
+    //! @brief 序列化页面参数
+    static QByteArray encodeParams(const QVariantMap& params) {
+        QByteArray bytes;
+        QDataStream out(&bytes, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_15);
+        out << streamableParams(params);
+        return bytes;
+    }
+
+    //! @brief 反序列化页面参数
+    static QVariantMap decodeParams(const QByteArray& bytes) {
+        QVariantMap params;
+        QDataStream in(bytes);
+        in.setVersion(QDataStream::Qt_5_15);
+        in >> params;
+        return params;
+    }
+
+    //! @brief 页面首次被访问时, 应用会话快照中的参数
+    void applySessionParams(AbstractPage* page) {
+        if (m_sessionParams.isEmpty())
+            return;
+        auto it = m_sessionParams.find(page->pagePath());
+        if (it == m_sessionParams.end())
+            return;
+        if (page->m_lastParams.isEmpty())
+            page->m_lastParams = decodeParams(it.value());
+        m_sessionParams.erase(it);
+        if (m_sessionParams.isEmpty())
+            m_sessionFile.reset();
+    }
+
+    //! @brief 将尚未应用的会话参数复制出映射, 然后关闭快照文件
+    void releaseSessionFile() {
+        if (m_sessionFile.isNull())
+            return;
+        for (auto it = m_sessionParams.begin(); it != m_sessionParams.end(); ++it)
+            it.value() = QByteArray(it.value().constData(), it.value().size());
+        m_sessionFile.reset();
+    }
+
+    //! @brief 将历史转换为路径栈, 栈顶为最近的记录
+    QStack<QString> historyPaths(const History& history) const {
+        QStack<QString> result;
+        result.reserve(history.size());
+        for (int i = history.firstIndex(); i <= history.lastIndex() && !history.isEmpty(); ++i)
+            result.push(pathOf(history.at(i).pageId));
+        return result;
+    }
+
+    //! @brief 在线程池中开始页面的异步准备, 页面已经准备完成或正在准备时不做任何事.
+    void startPrepare(AbstractPage* page);
+
+    //! @brief 在GUI线程中完成页面的异步准备
+    //! @param key 启动准备时的页面地址, 用于在 m_preparing 中移除任务, 页面可能已被销毁
+    void finishPrepare(AbstractPage* key, QPointer<AbstractPage> page, QFutureInterface<QVariant> control);
+
+    //! @brief page 或其子孙页面是否有尚未结束的后台准备任务
+    bool isPreparing(const AbstractPage* page) const {
+        for (auto it = m_preparing.constBegin(); it != m_preparing.constEnd(); ++it)
+            if (isDescendant(it.key(), page))
+                return true;
+        return false;
+    }
+
+    //! @brief 取消并等待 page 及其子孙页面的后台准备任务结束, 在销毁页面之前调用
+    //! @note 等待期间阻塞GUI线程, 因此 pagePrepare() 中不能等待GUI线程.
+    void waitForPrepares(const AbstractPage* page) {
+        for (auto it = m_preparing.begin(); it != m_preparing.end(); ) {
+            if (isDescendant(it.key(), page)) {
+                for (auto& control : it.value())
+                    control.cancel();
+                for (auto& control : it.value())
+                    control.waitForFinished();
+                it = m_preparing.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    //! @brief 用户输入时停止预热
+    bool eventFilter(QObject* watched, QEvent* event) override {
+        switch (event->type()) {
+        case QEvent::MouseButtonPress:
+        case QEvent::KeyPress:
+        case QEvent::Wheel:
+        case QEvent::TouchBegin:
+            if (!m_prewarmQueue.isEmpty())
+                stopPrewarming();
+            break;
+        case QEvent::Show:
+            // 页面再次显示, 执行被推迟的更新
+            if (!m_deferredPages.isEmpty())
+                if (auto page = qobject_cast<AbstractPage*>(watched))
+                    page->flushUpdates();
+            break;
+        default:
+            break;
+        }
+        return QObject::eventFilter(watched, event);
+    }
+
+    //! @brief 将 path 之后最可能访问的页面放入预热队列
+    void schedulePrewarm(const QString& path) {
+        m_prewarmQueue.clear();
+        auto it = m_transitions.constFind(pathId(path));
+        if (it == m_transitions.constEnd())
+            return;
+
+        QVector<QPair<quint32, quint32>> candidates; // (次数, 编号)
+        for (auto t = it->constBegin(); t != it->constEnd(); ++t) {
+            auto page = m_pathIndex.value(m_idPaths[int(t.key())]);
+            if (page == nullptr || page->m_state == AbstractPage::Constructed)
+                candidates.append({ t.value(), t.key() });
+        }
+        std::sort(candidates.begin(), candidates.end(), 
+            [](const QPair<quint32, quint32>& a, const QPair<quint32, quint32>& b) { return a.first > b.first; });
+
+        for (int i = 0; i < candidates.size() && i < m_prewarmCandidates; ++i)
+            m_prewarmQueue.append(candidates[i].second);
+        if (!m_prewarmQueue.isEmpty())
+            m_prewarmTimer.start();
+    }
+
+    //! @brief 在一个空闲时间片内预热队列中的页面
+    void prewarmSlice() {
+        QElapsedTimer elapsed;
+        elapsed.start();
+        while (!m_prewarmQueue.isEmpty() && elapsed.elapsed() < m_prewarmSliceMs) {
+            QString path = m_idPaths[int(m_prewarmQueue.takeFirst())];
+            auto existing = m_pathIndex.value(path);
+            if (existing && existing->m_state != AbstractPage::Constructed)
+                continue;
+            if (auto p = page(path)) {
+                m_prewarmedPages.insert(p);
+                ++m_prewarmStats.prewarmed;
+            }
+        }
+        if (!m_prewarmQueue.isEmpty())
+            m_prewarmTimer.start();
+    }
+
+    //! @brief 清空预热队列
+    void stopPrewarming() {
+        m_prewarmQueue.clear();
+        m_prewarmTimer.stop();
+    }
+
+    //! @brief 页面是否不可被回收: 处于激活状态或正在准备, 位于当前路径上, 或者自身及子页面位于前进/后退历史中
+    //! @param history historyPaths() 的结果, 每次回收时只计算一次
+    bool isPagePinned(AbstractPage* page, const QSet<QString>& history) const;
+
+    //! @brief 前进/后退历史中的路径及其所有祖先路径
+    QSet<QString> historyPaths() const;
+
+    //! @brief 按最近最少使用的顺序回收延迟页面, 直到满足内存预算
+    void enforcePageBudget();
+
+protected:
+    PagesContainer* m_root = nullptr;
+    AbstractPage*   m_currentPage = nullptr;
+    QHash<QString, AbstractPage*> m_pathIndex; //!< 规范路径 -> 页面实例
+    QHash<RouteId, AbstractPage*> m_routeIndex;//!< 路由标识 -> 页面实例
+    QSet<AbstractPage*> m_factoryPages;        //!< 存活的延迟页面实例
+    QVector<QPair<QPointer<PagesContainer>, QString>> m_overfullPools; //!< 超出容量的页面池: 容器, 路由名称
+    //! @brief 后台准备任务尚未结束的页面及其任务, 任务在 finishPrepare() 中移除
+    //! @note 被取消的任务同样保留到结束为止, 在此之前页面不会被回收, 卸载时则等待其结束, 参见 waitForPrepares().
+    QHash<AbstractPage*, QVector<QFutureInterface<QVariant>>> m_preparing;
+    bool    m_prewarming = false;              //!< 是否启用预热
+    int     m_prewarmCandidates = 3;           //!< 每次导航后最多预热的页面数
+    int     m_prewarmSliceMs = 4;              //!< 每个空闲时间片的预算(毫秒)
+    QTimer  m_prewarmTimer;                    //!< 空闲时触发预热
+    QVector<quint32> m_prewarmQueue;           //!< 等待预热的页面编号
+    QSet<AbstractPage*> m_prewarmedPages;      //!< 已预热但尚未被访问的页面
+    PrewarmStats m_prewarmStats;
+    PoolStats    m_poolStats;
+    bool    m_snapshotCache = false;           //!< 是否缓存页面快照
+    bool    m_snapshotPending = false;         //!< 下一次切换由后退/前进发起, 需要先显示快照
+    QCache<quint32, QPixmap> m_snapshots;      //!< 页面编号 -> 快照, 开销以 KB 计
+    QPointer<QLabel> m_snapshotOverlay;        //!< 正在显示的快照
+    QPointer<AbstractPage> m_snapshotTarget;   //!< 正在显示快照的页面
+    SnapshotStats m_snapshotStats;
+    QSet<AbstractPage*> m_deferredPages;       //!< 有被推迟的更新的页面
+    UpdateStats  m_updateStats;
+    QHash<quint32, QHash<quint32, quint32>> m_transitions; //!< 页面跳转次数: from -> (to -> 次数)
+    QHash<QString, QVariantMap> m_evictedParams; //!< 被回收页面的 m_lastParams
+    QSet<quint32> m_evictedIds;                //!< 被回收页面的路径编号
+    quint64 m_useClock = 0;                    //!< 页面访问计数, 用于 LRU
+    int     m_budgetPages = 0;                 //!< 延迟页面实例数上限, 0 不限制
+    qint64  m_budgetBytes = 0;                 //!< 延迟页面内存上限, 0 不限制
+    History         m_stackBack;               //!< 后退历史
+    History         m_stackForward;            //!< 前进历史
+    HistoryPolicy   m_historyPolicy = KeepDuplicates;
+    SwitchMode      m_switchMode = FullSwitch;
+    bool            m_coalescing = false;      //!< 是否合并导航
+    bool            m_flushScheduled = false;  //!< 是否已安排执行合并的导航
+    CoalescePolicy  m_coalescePolicy = DropSkippedParams;
+    QVector<PendingSwitch> m_pendingSwitches;  //!< 合并导航中尚未处理的请求
+    bool            m_historySnapshots = false;
+    QHash<QString, quint32> m_pathIds;         //!< 规范路径 -> 编号
+    QVector<QString>        m_idPaths;         //!< 编号 -> 规范路径
+    bool            m_tracing = false;         //!< 是否追踪页面事件的耗时
+    QElapsedTimer   m_traceClock;              //!< 追踪事件的时间基准
+    QScopedArrayPointer<TraceSlot> m_traceSlots; //!< 追踪事件的环形缓冲区
+    quint64         m_traceMask = 0;           //!< 环形缓冲区容量 - 1
+    QAtomicInteger<quint64> m_traceHead;       //!< 下一个写入的序号
+    QScopedPointer<QDataStream> m_recorder;    //!< 导航记录的输出流
+    QHash<QString, quint32> m_recordStrings;   //!< 导航记录中已定义的字符串
+    QElapsedTimer   m_recordClock;             //!< 导航记录的时间基准
+    int             m_recordDepth = 0;         //!< 导航调用的嵌套深度
+    QScopedPointer<QFile> m_sessionFile;       //!< 被映射的会话快照文件
+    QHash<QString, QByteArray> m_sessionParams;//!< 尚未访问的页面在快照中的参数, 指向映射的内存
+    QAtomicPointer<InvokeNode> m_invokeHead;   //!< 异步调用队列的队尾(生产者写入端)
+    InvokeNode*     m_invokeTail = nullptr;    //!< 异步调用队列的哨兵(GUI线程读取端)
+    QAtomicInt      m_invokeQueued;            //!< 队列中的消息数
+    QAtomicInt      m_invokeScheduled;         //!< 是否已安排取出队列
+    QVector<PendingInvoke> m_invokeBacklog;    //!< 已取出但尚未交付的消息
+    int             m_invokeBudgetMs = 8;      //!< 每批处理的时间预算(毫秒)
+    InvokeStats     m_invokeStats;
+    QHash<QString, quint32> m_topicIds;        //!< 主题名称 -> 编号
+    QVector<QString>        m_topicNames;      //!< 编号 -> 主题名称
+    QVector<QVector<Subscription>> m_subscribers; //!< 编号 -> 订阅者
+    quint64 m_unsubscribes = 0;                //!< 退订计数, 发布期间据此判断订阅者是否可能已失效
+};
+
+//! @brief 导航记录回放器
+//! @note 读取 PagesManager::startRecording() 产生的记录, 在当前的页面树上按原始速度或尽可能快地重放,
+//!       并报告总耗时与每一步的耗时; 配合 QT_QPA_PLATFORM=offscreen 可以在无界面的环境中运行.
+//! @code
+//!   NavigationReplayer replayer;
+//!   if (replayer.load(&file)) {
+//!       auto report = replayer.replay();
+//!       qDebug() << report.totalNs << report.percentile(99, PagesManager::CallGoto);
+//!   }
+//! @endcode
+class NavigationReplayer
+{
+public:
+    //! @brief 一次记录的调用
+    struct Step
+    {
+        PagesManager::NavigationCall call;
+        qint64      start;      //!< 相对于记录开始的时间(纳秒)
+        qint64      duration;   //!< 记录时的耗时(纳秒)
+        quint32     callerId;   //!< 调用者路径的编号, 参见 string()
+        quint32     calleeId;   //!< 目标路径的编号, pageBack()/pageForward() 为空字符串
+        QVariantMap params;
+    };
+
+    //! @brief 回放报告
+    struct Report
+    {
+        int     steps = 0;          //!< 执行的步骤数
+        int     skipped = 0;        //!< 因目标页面不存在或没有历史而跳过的步骤数
+        qint64  totalNs = 0;        //!< 回放的总耗时(纳秒), 按原始速度回放时包括步骤之间的等待
+        QVector<quint8> calls;      //!< 每一步的调用类型
+        QVector<qint64> latencies;  //!< 每一步的耗时(纳秒), 跳过的步骤为 -1
+
+        //! @brief 返回指定调用类型的耗时百分位数(纳秒)
+        //! @param call 调用类型, -1 表示全部
+        qint64 percentile(int p, int call = -1) const {
+            QVector<qint64> samples;
+            for (int i = 0; i < latencies.size(); ++i)
+                if (latencies[i] >= 0 && (call < 0 || calls[i] == call))
+                    samples.append(latencies[i]);
+            if (samples.isEmpty())
+                return 0;
+            std::sort(samples.begin(), samples.end());
+            return samples[qBound(0, (samples.size() * p + 99) / 100 - 1, samples.size() - 1)];
+        }
+    };
+
+    //! @brief 读取导航记录
+    //! @return 格式或版本不匹配时返回 false
+    bool load(QIODevice* device) {
+        m_steps.clear();
+        m_strings.clear();
+
+        QDataStream in(device);
+        in.setVersion(QDataStream::Qt_5_15);
+        quint32 magic = 0;
+        quint16 version = 0;
+        in >> magic >> version;
+        if (magic != PagesManager::RecordMagic || version != PagesManager::RecordVersion)
+            return false;
+
+        while (!in.atEnd() && in.status() == QDataStream::Ok) {
+            quint8 kind = 0;
+            in >> kind;
+            if (kind == PagesManager::RecordString) {
+                quint32 id = 0;
+                QString text;
+                in >> id >> text;
+                if (id != quint32(m_strings.size()))
+                    return false;
+                m_strings.append(text);
+                continue;
+            }
+
+            Step step;
+            step.call = PagesManager::NavigationCall(kind);
+            in >> step.start >> step.duration >> step.callerId >> step.calleeId >> step.params;
+            if (kind > PagesManager::CallInvoke 
+                || step.callerId >= quint32(m_strings.size()) || step.calleeId >= quint32(m_strings.size()))
+                return false;
+            m_steps.append(std::move(step));
+        }
+        return in.status() == QDataStream::Ok;
+    }
+
+    const QVector<Step>& steps() const { return m_steps; }
+
+    //! @brief 返回记录中的字符串(页面路径)
+    const QString& string(quint32 id) const { return m_strings[int(id)]; }
+
+    //! @brief 在当前的页面树上回放导航记录
+    //! @param speed 回放速度, 1.0 为原始速度, 0 表示尽可能快
+    //! @note 每一步之后处理一次事件循环, 以便合并导航、异步准备等排队的工作得以执行; 这部分时间不计入单步耗时.
+    Report replay(double speed = 0.0) {
+        PagesManager& manager = PagesManager::instance();
+        Report report;
+        report.calls.reserve(m_steps.size());
+        report.latencies.reserve(m_steps.size());
+
+        QElapsedTimer clock;
+        clock.start();
+        const qint64 origin = m_steps.isEmpty() ? 0 : m_steps.first().start;
+        for (const auto& step : m_steps)
+        {
+            if (speed > 0) {
+                const qint64 due = qint64((step.start - origin) / speed);
+                for (qint64 now = clock.nsecsElapsed(); now < due; now = clock.nsecsElapsed()) {
+                    QCoreApplication::processEvents();
+                    QThread::usleep(ulong(qMin<qint64>(1000, (due - now) / 1000 + 1)));
+                }
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            bool done = run(manager, step);
+            report.calls.append(quint8(step.call));
+            report.latencies.append(done ? timer.nsecsElapsed() : -1);
+            ++(done ? report.steps : report.skipped);
+
+            QCoreApplication::processEvents();
+        }
+
+        report.totalNs = clock.nsecsElapsed();
+        return report;
+    }
+
+protected:
+    //! @brief 执行一步, 目标页面不存在或没有可用的历史时返回 false
+    //! @note 以 page() 的结果判断目标页面是否存在: hasPage() 对尚未构造的延迟页面之下的路径同样返回 true.
+    bool run(PagesManager& manager, const Step& step) const {
+        const QString& caller = string(step.callerId);
+        const QString& callee = string(step.calleeId);
+        switch (step.call) {
+        case PagesManager::CallSwitch:
+            if (!manager.page(callee))
+                return false;
+            manager.pageSwitch(caller, callee, step.params);
+            return true;
+        case PagesManager::CallGoto:
+            if (!manager.page(callee))
+                return false;
+            manager.pageGoto(caller, callee, step.params);
+            return true;
+        case PagesManager::CallBack:
+            if (!manager.canBack())
+                return false;
+            manager.pageBack(caller, step.params);
+            return true;
+        case PagesManager::CallForward:
+            if (!manager.canForward())
+                return false;
+            manager.pageForward(caller, step.params);
+            return true;
+        case PagesManager::CallInvoke:
+            if (!manager.page(callee))
+                return false;
+            manager.pageInvoke(caller, callee, step.params);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    QVector<Step>    m_steps;
+    QVector<QString> m_strings;
+};
+
+//! @brief 页面树模型
+//! @note 直接由页面树支撑的单列模型, 每个页面(包括尚未构造的延迟页面)对应一行, 兄弟页面按名称排序.
+//!       安装页面时增量地插入行, 从页面路径到模型索引的查找只需一次哈希查找.
+//! @note 与 PagesManager::visitPages() 一致: 延迟页面被回收后, 其子孙页面的行被移除, 重新构造时再插入;
+//!       页面池中的实例没有对应的行.
+class PagesTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum Roles
+    {
+        PathRole = Qt::UserRole,    //!< 页面路径
+        ShortcodeRole,              //!< 页面的短码路径
+    };
+
+    explicit PagesTreeModel(QObject* parent = nullptr)
+        : QAbstractItemModel(parent)
+    {
+        auto& manager = PagesManager::instance();
+        connect(&manager, &PagesManager::pageInstalled, this, &PagesTreeModel::addPage);
+        connect(&manager, &PagesManager::pageUninstalled, this, &PagesTreeModel::removePage);
+        connect(&manager, &PagesManager::pageEvicted, this, &PagesTreeModel::evictPage);
+        connect(&manager, &PagesManager::rootContainerChanged, this, &PagesTreeModel::reload);
+        reload();
+    }
+
+    ~PagesTreeModel() {
+        qDeleteAll(m_nodes);
+    }
+
+    //! @brief 返回页面路径对应的模型索引, 路径须为规范形式(小写, 以 / 开头)
+    QModelIndex indexOf(const QString& path) const {
+        Node* node = m_nodes.value(path);
+        return node ? createIndex(node->row, 0, node) : QModelIndex();
+    }
+
+    //! @brief 返回模型索引对应的页面路径
+    QString pathOf(const QModelIndex& index) const {
+        return index.isValid() ? node(index)->path : QString();
+    }
+
+    //! @brief 按当前的页面树重建模型
+    void reload() {
+        beginResetModel();
+        qDeleteAll(m_nodes);
+        m_nodes.clear();
+        m_root.children.clear();
+
+        QVector<Node*> stack;
+        stack.append(&m_root);
+        PagesManager::instance().visitPages([&](const QString& name, AbstractPage*, int depth) {
+            stack.resize(depth + 1);
+            stack.append(insertNode(stack[depth], name, false));
+            return true;
+        });
+        endResetModel();
+    }
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override {
+        const Node* p = parent.isValid() ? node(parent) : &m_root;
+        if (column != 0 || row < 0 || row >= p->children.size())
+            return {};
+        return createIndex(row, column, p->children[row]);
+    }
+
+    QModelIndex parent(const QModelIndex& index) const override {
+        if (!index.isValid())
+            return {};
+        Node* p = node(index)->parent;
+        return p == &m_root ? QModelIndex() : createIndex(p->row, 0, p);
+    }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override {
+        if (parent.column() > 0)
+            return 0;
+        return (parent.isValid() ? node(parent) : &m_root)->children.size();
+    }
+
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override {
+        return 1;
+    }
+
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override {
+        if (!index.isValid())
+            return {};
+        switch (role) {
+        case Qt::DisplayRole:
+            return node(index)->name;
+        case PathRole:
+            return node(index)->path;
+        case ShortcodeRole:
+            return PagesManager::instance().toShortcodePath(node(index)->path);
+        }
+        return {};
+    }
+
+protected:
+    struct Node
+    {
+        QString         name;
+        QString         path;
+        Node*           parent = nullptr;
+        int             row = 0;        //!< 在父节点中的行号
+        QVector<Node*>  children;       //!< 按名称排序的子节点
+    };
+
+    Node* node(const QModelIndex& index) const {
+        return static_cast<Node*>(index.internalPointer());
+    }
+
+    //! @brief 在 parent 下插入名为 name 的节点, 已存在时直接返回
+    Node* insertNode(Node* parent, const QString& name, bool notify) {
+        auto it = std::lower_bound(parent->children.begin(), parent->children.end(), name,
+            [](const Node* n, const QString& name) { return n->name < name; });
+        if (it != parent->children.end() && (*it)->name == name)
+            return *it;
 
-            auto path = page->pagePath();
-            if (params.contains(path)) 
-                callPageEnter(page, callerPagePath, params.value(path).value<QVariantMap>());
-            else if (!params.isEmpty() && hops.last() == n)
-                callPageEnter(page, callerPagePath, params);
+        int row = int(it - parent->children.begin());
+        if (notify)
+            beginInsertRows(parent == &m_root ? QModelIndex() : createIndex(parent->row, 0, parent), row, row);
 
-            page->pageShow();
-            page->pageRaises();
-        }
+        auto n = new Node;
+        n->name = name;
+        n->path = parent->path + "/" + name;
+        n->parent = parent;
+        parent->children.insert(row, n);
+        for (int i = row; i < parent->children.size(); ++i)
+            parent->children[i]->row = i;
+        m_nodes.insert(n->path, n);
 
-        m_currentPage = page;
-        emit currentPageChanged(callerPagePath, calleePagePath);
+        if (notify)
+            endInsertRows();
+        return n;
     }
 
-    //! @brief 页面跳转
-    //! @param callerPagePath 发起跳转的页面路径, 如果为空, 则表示由外部触发
-    //! @param calleePagePath 要跳转的页面路径, 大小写不敏感
-    //! @param params 页面参数, 如果不为空, 目标页面将会触发 pageEnter() 事件。
-    //! @note 这种方式产生的切换将产生历史, 这意味着可以通过 pageBack() 和 pageForward() 进行导航, 页面成功跳转后将发射 currentPageChanged() 信号。
-    void pageGoto(QString callerPagePath, QString calleePagePath, const QVariantMap& params) {
-        callerPagePath = callerPagePath.toLower();
-        calleePagePath = calleePagePath.toLower();
+    //! @brief 响应 PagesManager::pageInstalled(), 插入页面及其已构造的子孙页面
+    void addPage(const QString& path) {
+        Node* n = &m_root;
+        for (const auto& hop : path.split('/', Qt::SkipEmptyParts))
+            n = insertNode(n, hop, true);
 
-        if (callerPagePath.size())
-            m_stackBack.push(callerPagePath);
-        m_stackForward.clear();
-        pageSwitch(callerPagePath, calleePagePath, params);
-    }
+        auto page = PagesManager::instance().existingPage(path);
+        if (page == nullptr)
+            return;
 
-    //! @brief 返回到前一个页面
-    //! @param callerPagePath 发起跳转的页面路径, 不能为空.
-    void pageForward(QString callerPagePath, const QVariantMap& params) {
-        Q_ASSERT(canForward());
-        m_stackBack.push(callerPagePath);
-        pageSwitch(callerPagePath.toLower(), m_stackForward.pop(), params);
+        QVector<Node*> stack;
+        stack.append(n);
+        PagesManager::instance().visitPages([&](const QString& name, AbstractPage*, int depth) {
+            stack.resize(depth + 1);
+            stack.append(insertNode(stack[depth], name, true));
+            return true;
+        }, page);
     }
 
-    //! @brief 返回到后一个页面
-    //! @param callerPagePath 发起跳转的页面路径, 不能为空.
-    void pageBack(QString callerPagePath, const QVariantMap& params) {
-        Q_ASSERT(canBack());
-        m_stackForward.push(callerPagePath);
-        pageSwitch(callerPagePath.toLower(), m_stackBack.pop(), params);
-    }
+    //! @brief 响应 PagesManager::pageUninstalled(), 移除页面及其子孙页面
+    void removePage(const QString& path) {
+        Node* n = m_nodes.value(path);
+        if (n == nullptr)
+            return;
 
-    //! @brief 页面调用方法
-    //! @param callerPagePath 发起调用的页面路径, 如果为空, 则表示由外部触发。
-    //! @param calleePagePath 要调用的页面路径, 大小写不敏感
-    //! @param params 页面参数, 目标页面将会触发 pageInvoke() 事件。
-    //! @return 调用结果, 由页面的 pageInvoke() 事件返回。
-    QVariant pageInvoke(QString callerPagePath, QString calleePagePath, const QVariantMap& params) {
-        return page(calleePagePath)->pageInvoke(callerPagePath.toLower(), params);
+        Node* parent = n->parent;
+        beginRemoveRows(parent == &m_root ? QModelIndex() : createIndex(parent->row, 0, parent), n->row, n->row);
+        parent->children.remove(n->row);
+        for (int i = n->row; i < parent->children.size(); ++i)
+            parent->children[i]->row = i;
+        deleteNode(n);
+        endRemoveRows();
     }
 
-    //! @brief 将正常页面路径转换为短码路径
-    //! @param normalPath 正常页面路径, 格式: /page1/page2/page3
-    //! @return 短码路径, 格式: p1p2p3 (每个页面的短码连接, 无分隔符)
-    QString toShortcodePath(QString normalPath) const {
-        if (normalPath.isEmpty())
-            return {};
-        
-        // 移除首尾的 /
-        normalPath = normalPath.toLower();
-        if (normalPath.startsWith("/"))
-            normalPath = normalPath.mid(1);
-        if (normalPath.endsWith("/"))
-            normalPath = normalPath.left(normalPath.length() - 1);
-        
-        QStringList hops = normalPath.split("/", Qt::SkipEmptyParts);
-        QString result;
-        
-        for (const auto& hop : hops) {
-            result += ShortcodeAllocator::instance().pageCode(hop);;
-        }
-        
-        return result;
-    }
+    //! @brief 响应 PagesManager::pageEvicted(), 移除页面的子孙页面, 页面本身作为尚未构造的延迟页面保留
+    void evictPage(const QString& path) {
+        Node* n = m_nodes.value(path);
+        if (n == nullptr || n->children.isEmpty())
+            return;
 
-    //! @brief 将短码路径转换为正常页面路径
-    //! @param shortcodePath 短码路径, 格式: p1p2p3 (每个短码为2字符)
-    //! @return 正常页面路径, 格式: /page1/page2/page3, 转换失败返回空字符串
-    QString fromShortcodePath(const QString& shortcodePath) const {
-        if (shortcodePath.isEmpty() || shortcodePath.length() % 2 != 0)
-            return {};
-        
-        QStringList hops;
-        ShortcodeAllocator& allocator = ShortcodeAllocator::instance();
-        
-        // 按2字符一组分割并转换
-        for (int i = 0; i < shortcodePath.length(); i += 2) {
-            QString code = shortcodePath.mid(i, 2);
-            QString name = allocator.pageName(code);
-            
-            if (name.isEmpty())
-                return {};  // 短码不存在
-            
-            hops.append(name);
-        }
-        
-        return "/" + hops.join("/");
+        beginRemoveRows(createIndex(n->row, 0, n), 0, n->children.size() - 1);
+        for (auto child : n->children)
+            deleteNode(child);
+        n->children.clear();
+        endRemoveRows();
     }
 
-public:
-    //! @brief 当前以任何方式切换当前页面时, 将发射此信号。
-    Q_SIGNAL void currentPageChanged(QString oldPagePath, QString newPagePath);
+    void deleteNode(Node* n) {
+        for (auto child : n->children)
+            deleteNode(child);
+        m_nodes.remove(n->path);
+        delete n;
+    }
 
-protected:
-    PagesContainer* m_root = nullptr;
-    AbstractPage*   m_currentPage = nullptr;
-    QStack<QString> m_stackBack;
-    QStack<QString> m_stackForward;
+private:
+    Node                 m_root;    //!< 不可见的根节点, 其子节点为顶级页面
+    QHash<QString, Node*> m_nodes;  //!< 页面路径 -> 节点
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -639,17 +3902,106 @@ inline AbstractPage::AbstractPage(PagesContainer* container /*= nullptr*/)
     , m_parent(container)
 {}
 
+inline AbstractPage::~AbstractPage() {
+    // 页面可能在 QApplication 及其子对象(管理器)之后才被销毁, 此时没有需要注销的记录
+    if (auto manager = PagesManager::existingInstance())
+        manager->pageDestroyed(this);
+    if (m_parent)
+        m_parent->forgetPage(this);
+
+    // 子容器随后由 QWidget 的析构函数销毁, 此时本页面的成员已不可访问
+    for (auto c : m_containers)
+        c->m_parentPage = nullptr;
+}
+
+inline bool AbstractPage::isOnScreen() const {
+    return PagesManager::instance().isOnScreen(this);
+}
+
+inline bool AbstractPage::deferUpdate(const QString& key, std::function<void()> update) {
+    auto& manager = PagesManager::instance();
+    if (manager.isOnScreen(this)) {
+        ++manager.m_updateStats.immediate;
+        update();
+        return true;
+    }
+
+    if (!key.isEmpty()) {
+        for (auto& pending : m_deferredUpdates) {
+            if (pending.first == key) {
+                pending.second = std::move(update);
+                ++manager.m_updateStats.coalesced;
+                return false;
+            }
+        }
+    }
+
+    // 首次推迟时监听页面的显示事件
+    if (m_deferredUpdates.isEmpty()) {
+        manager.m_deferredPages.insert(this);
+        installEventFilter(&manager);
+    }
+    m_deferredUpdates.append(qMakePair(key, std::move(update)));
+    ++manager.m_updateStats.deferred;
+    return false;
+}
+
+inline void AbstractPage::flushUpdates() {
+    if (m_deferredUpdates.isEmpty())
+        return;
+
+    auto& manager = PagesManager::instance();
+    auto updates = std::move(m_deferredUpdates);
+    m_deferredUpdates.clear();
+    manager.m_deferredPages.remove(this);
+    removeEventFilter(&manager);
+
+    manager.m_updateStats.flushed += updates.size();
+    for (auto& pending : updates)
+        pending.second();
+}
+
+inline void AbstractPage::subscribe(const QString& topic, NotifyFlags flags /*= NotifyActive*/) {
+    PagesManager::instance().subscribe(this, topic, flags);
+}
+
+inline void AbstractPage::unsubscribe(const QString& topic) {
+    auto& manager = PagesManager::instance();
+    auto it = manager.m_topicIds.constFind(topic);
+    if (it != manager.m_topicIds.constEnd())
+        manager.unsubscribe(this, it.value());
+}
+
+inline void AbstractPage::setSnapshotEnabled(bool enable) {
+    m_snapshotEnabled = enable;
+    if (!enable)
+        invalidateSnapshot();
+}
+
+inline void AbstractPage::invalidateSnapshot() {
+    auto& manager = PagesManager::instance();
+    auto it = manager.m_pathIds.constFind(pagePath());
+    if (it != manager.m_pathIds.constEnd())
+        manager.m_snapshots.remove(it.value());
+}
+
+inline void AbstractPage::setParamSchema(PageParamSchema schema) {
+    Q_ASSERT(m_parent);
+    m_parent->setParamSchema(m_poolKey.isNull() ? m_name : m_name.left(m_name.size() - m_poolKey.size() - 1), 
+        std::move(schema));
+}
+
 inline void AbstractPage::pageRaises() {
     Q_ASSERT(m_parent);
-    m_parent->setCurrentPage(name());
+    m_parent->setCurrentWidget(this);
 }
 
-inline const QMap<QString, AbstractPage*> AbstractPage::subpages() const {
+inline const QMap<QString, AbstractPage*> AbstractPage::subpages(bool create /*= true*/) const {
     if (m_containers.isEmpty())
         return {};
     QMap<QString, AbstractPage*> result;
     for (auto c : m_containers)
-        result.insert(c->pages());
+        result.insert(c->pages(create));
     return result;
 }
 
@@ -679,10 +4031,697 @@ inline void AbstractPage::pageForward(const QVariantMap& params) {
     PagesManager::instance().pageForward(pagePath(), params);
 }
 
+inline void AbstractPage::invalidatePath() {
+    m_pathCache.clear();
+    m_codePathCache.clear();
+    for (auto c : m_containers)
+        c->visitCreated([](AbstractPage* p) { p->invalidatePath(); });
+}
+
 inline void AbstractPage::installContainer(PagesContainer* container) {
     Q_ASSERT(container);
+#ifndef QT_NO_DEBUG
+    // 兄弟容器使用不同的短码作用域时, 同一短码不能同时指向两个容器中的页面
+    for (auto sibling : m_containers) {
+        if (sibling->m_scope.data() == container->m_scope.data())
+            continue;
+        for (auto it = container->m_names.constBegin(); it != container->m_names.constEnd(); ++it) {
+            QString other = sibling->shortcodes().pageName(container->shortcodes().pageCode(it.key()));
+            Q_ASSERT_X(other.isEmpty() || !sibling->m_names.contains(other), "AbstractPage::installContainer",
+                       QString("Ambiguous shortcode: %1").arg(it.key()).toStdString().c_str());
+        }
+    }
+#endif
     m_containers.insert(container);
     container->m_parentPage = this;
+    container->visitCreated([](AbstractPage* p) { p->invalidatePath(); });
+    PagesManager::instance().indexContainer(container);
+    for (auto it = container->begin(); it != container->end(); ++it)
+        PagesManager::instance().pageAttached(container, it.name());
+}
+
+inline void AbstractPage::uninstallContainer(PagesContainer* container) {
+    Q_ASSERT(container && m_containers.contains(container));
+    if (!m_containers.contains(container))
+        return;
+
+    container->uninstallPages(container->m_names.keys() + container->m_pools.keys());
+    m_containers.remove(container);
+    container->m_parentPage = nullptr;
+    container->hide();
+    container->deleteLater();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+inline void PagesContainer::installPageWithCode(QString name, QString shortcode, AbstractPage* page) {
+    name = name.toLower();
+    QString assignedCode = reservePage(name, shortcode);
+    if (assignedCode.isEmpty())
+        return;
+
+    m_names[name] = QStackedWidget::addWidget(page);
+    bindPage(name, assignedCode, page);
+    PagesManager::instance().pageAttached(this, name);
+}
+
+inline void PagesContainer::installPageWithCode(QString name, QString shortcode, PageFactory factory) {
+    name = name.toLower();
+    Q_ASSERT(factory);
+    QString assignedCode = reservePage(name, shortcode);
+    if (assignedCode.isEmpty())
+        return;
+
+    // 使用占位控件保留页面在 QStackedWidget 中的位置
+    auto placeholder = new QWidget();
+    placeholder->setObjectName(name);
+    m_names[name] = QStackedWidget::addWidget(placeholder);
+    m_factories[name] = std::move(factory);
+    PagesManager::instance().pageAttached(this, name);
+}
+
+inline void PagesContainer::installPagePool(QString name, PageFactory factory, int capacity /*= 4*/) {
+    name = name.toLower();
+    Q_ASSERT(factory && !name.contains(':') && !m_pools.contains(name));
+    QString assignedCode = reservePage(name, {});
+    if (assignedCode.isEmpty())
+        return;
+
+    PagePool& pool = m_pools[name];
+    pool.factory = std::move(factory);
+    pool.code = assignedCode;
+    pool.capacity = qMax(1, capacity);
+}
+
+inline AbstractPage* PagesContainer::poolPage(const QString& name) {
+    PagePool* pool = poolOf(name);
+    if (pool == nullptr)
+        return nullptr;
+    for (auto page : pool->members)
+        if (page->m_name == name)
+            return page;
+    return PagesManager::instance().acquirePooled(this, *pool, name);
+}
+
+inline void PagesContainer::uninstallPages(QStringList names) {
+    QSet<QString> removed;
+    for (const auto& name : names) {
+        QString lower = name.toLower();
+        if (m_names.contains(lower) || m_pools.contains(lower))
+            removed.insert(lower);
+    }
+    if (removed.isEmpty())
+        return;
+
+    PagesManager::instance().uninstallPages(this, removed);
+
+    // 释放短码并收集要移除的控件位置
+    QVector<int> indices;
+    for (const auto& name : removed) {
+        shortcodes().release(name);
+        releaseHeld(m_heldCodes.take(name));
+        m_schemas.remove(name);
+        auto pool = m_pools.find(name);
+        if (pool != m_pools.end()) {
+            for (auto page : pool->members) {
+                for (auto c : page->m_containers)
+                    c->releaseShortcodes();
+                indices.append(QStackedWidget::indexOf(page));
+            }
+            m_pools.erase(pool);
+            continue;
+        }
+
+        int index = m_names.take(name);
+        m_factories.remove(name);
+        if (auto page = qobject_cast<AbstractPage*>(QStackedWidget::widget(index)))
+            for (auto c : page->m_containers)
+                c->releaseShortcodes();
+        indices.append(index);
+    }
+
+    // 从后向前移除控件, 页面可能正处于自身的调用栈中, 因此延迟销毁
+    std::sort(indices.begin(), indices.end());
+    for (int i = indices.size() - 1; i >= 0; --i) {
+        QWidget* widget = QStackedWidget::widget(indices[i]);
+        QStackedWidget::removeWidget(widget);
+        widget->hide();
+        widget->deleteLater();
+    }
+
+    // 一次性重排剩余页面的位置: 减去其前面被移除的控件数
+    for (auto it = m_names.begin(); it != m_names.end(); ++it)
+        it.value() -= int(std::lower_bound(indices.begin(), indices.end(), it.value()) - indices.begin());
+}
+
+inline PagesContainer::~PagesContainer() {
+    // 挂载在页面树中时, 与卸载相同地注销页面并释放短码; 须在成员销毁之前进行, 此时页面及其子树仍然完整
+    auto manager = PagesManager::existingInstance();
+    if (m_parentPage || (manager && manager->m_root == this)) {
+        if (manager)
+            manager->containerDestroyed(this);
+        releaseShortcodes();
+        if (m_parentPage)
+            m_parentPage->m_containers.remove(this);
+    }
+
+    // 页面已被注销, 不再逐个从容器中移除; 包括已被移出容器、等待延迟销毁的页面
+    for (auto child : children())
+        if (auto page = qobject_cast<AbstractPage*>(child))
+            page->m_parent = nullptr;
+    for (int i = QStackedWidget::count() - 1; i >= 0; --i)
+        delete QStackedWidget::widget(i);
+}
+
+inline void PagesContainer::forgetPage(AbstractPage* page) {
+    int index = QStackedWidget::indexOf(page);
+    if (index < 0)
+        return; // 已被移出容器, 例如卸载或回收之后被延迟销毁
+
+    for (auto c : page->m_containers)
+        c->releaseShortcodes();
+    if (auto pool = poolOf(page->m_name)) {
+        pool->members.removeOne(page);
+    }
+    else {
+        auto it = m_names.find(page->m_name);
+        if (it != m_names.end() && it.value() == index) {
+            shortcodes().release(it.key());
+            releaseHeld(m_heldCodes.take(it.key()));
+            m_factories.remove(it.key());
+            m_schemas.remove(it.key());
+            m_names.erase(it);
+
+            // 与卸载相同地通知 PagesTreeModel 等观察者
+            auto manager = PagesManager::existingInstance();
+            if (manager && manager->isAttached(this))
+                emit manager->pageUninstalled((m_parentPage ? m_parentPage->pagePath() : QString()) + "/" + page->m_name);
+        }
+    }
+
+    // 控件随后由 QWidget 的析构函数移出容器, 位于其后的页面前移一位
+    for (auto it = m_names.begin(); it != m_names.end(); ++it)
+        if (it.value() > index)
+            --it.value();
+}
+
+inline void PagesContainer::releaseShortcodes() {
+    for (auto it = m_names.constBegin(); it != m_names.constEnd(); ++it)
+        shortcodes().release(it.key());
+    for (auto it = m_pools.constBegin(); it != m_pools.constEnd(); ++it)
+        shortcodes().release(it.key());
+    for (const auto& held : m_heldCodes)
+        releaseHeld(held);
+    m_heldCodes.clear();
+    visitCreated([](AbstractPage* page) {
+        for (auto c : page->m_containers)
+            c->releaseShortcodes();
+    });
+}
+
+inline void PagesContainer::collectShortcodes(QVector<HeldCode>& codes) {
+    for (auto it = m_names.constBegin(); it != m_names.constEnd(); ++it)
+        codes.append({ m_scope, it.key() });
+    for (auto it = m_pools.constBegin(); it != m_pools.constEnd(); ++it)
+        codes.append({ m_scope, it.key() });
+    for (const auto& held : m_heldCodes)
+        codes += held;
+    m_heldCodes.clear();
+    visitCreated([&codes](AbstractPage* page) {
+        for (auto c : page->m_containers)
+            c->collectShortcodes(codes);
+    });
+}
+
+inline void PagesContainer::releaseHeld(const QVector<HeldCode>& codes) {
+    for (const auto& code : codes)
+        (code.scope ? *code.scope : ShortcodeAllocator::instance()).release(code.name);
+}
+
+inline void PagesContainer::showEvent(QShowEvent* e) {
+    if (auto page = pageAt(currentIndex()))
+        PagesManager::instance().initPage(page);
+    QStackedWidget::showEvent(e);
+}
+
+inline AbstractPage* PagesContainer::pageAt(int index) {
+    QWidget* widget = QStackedWidget::widget(index);
+    if (widget == nullptr)
+        return nullptr;
+    if (auto page = qobject_cast<AbstractPage*>(widget))
+        return page;
+
+    // 占位控件: 构造页面实例并替换到相同的位置
+    QString name = widget->objectName();
+    auto factory = m_factories.value(name);
+    Q_ASSERT(factory);
+    AbstractPage* page = factory ? factory() : nullptr;
+    Q_ASSERT(page);
+    if (page == nullptr)
+        return nullptr;
+
+    swapWidget(index, page);
+    delete widget;
+
+    bindPage(name, shortcodes().pageCode(name), page);
+    PagesManager::instance().pageCreated(page);
+    PagesManager::instance().pageAttached(this, name);
+    return page;
+}
+
+inline void PagesContainer::releasePage(AbstractPage* page) {
+    int index = QStackedWidget::indexOf(page);
+    Q_ASSERT(index >= 0 && m_factories.contains(page->name()));
+
+    auto placeholder = new QWidget();
+    placeholder->setObjectName(page->name());
+    swapWidget(index, placeholder);
+
+    // 页面可能正处于自身的调用栈中(例如在页面中发起的跳转), 因此延迟销毁
+    page->hide();
+    page->deleteLater();
+}
+
+inline void PagesContainer::swapWidget(int index, QWidget* widget) {
+    bool current = QStackedWidget::currentIndex() == index;
+    QStackedWidget::removeWidget(QStackedWidget::widget(index));
+    QStackedWidget::insertWidget(index, widget);
+    if (current)
+        QStackedWidget::setCurrentIndex(index);
+}
+
+inline QString PagesContainer::reservePage(const QString& name, const QString& shortcode) {
+    Q_ASSERT(!m_names.contains(name));
+    
+    // 分配或验证短码
+    QString assignedCode = shortcodes().assignShortcode(name, shortcode);
+    
+    // 指定的短码冲突或非法, 或者短码空间已经耗尽
+    if (assignedCode.isEmpty()) {
+        Q_ASSERT_X(false, "PagesContainer::installPageWithCode", 
+                   QString("Shortcode collision: %1 (%2)").arg(shortcode, name).toStdString().c_str());
+    }
+    return assignedCode;
+}
+
+inline void PagesContainer::bindPage(const QString& name, const QString& shortcode, AbstractPage* page) {
+    page->m_name = name;
+    page->m_shortcode = shortcode;
+    page->m_parent = this;
+    page->invalidatePath();
+    PagesManager::instance().indexPage(page);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+inline void PagesManager::collectHops(AbstractPage* page, PageHops& hops) {
+    for (auto p = page; p; p = p->parentPage())
+        hops.append(p);
+    std::reverse(hops.begin(), hops.end());
+}
+
+inline void PagesManager::lazyInit(AbstractPage* page) {
+    if (page->m_state == AbstractPage::Constructed) {
+        instance().traced(TraceLazyInit, page, [page] { page->pageLazyInit(); });
+        page->m_state = AbstractPage::Initialized;
+    }
+}
+
+inline bool PagesManager::isAttached(const PagesContainer* container) const {
+    while (container && container != m_root) {
+        auto parent = container->m_parentPage;
+        container = parent ? parent->m_parent : nullptr;
+    }
+    return container && container == m_root;
+}
+
+inline void PagesManager::indexPage(AbstractPage* page) {
+    if (!isAttached(page->m_parent))
+        return;
+    m_pathIndex.insert(page->pagePath(), page);
+    if (!isPooled(page)) {
+        RouteId route = RouteId::fromShortcodePath(page->shortcodePath());
+        if (!route.isNull())
+            m_routeIndex.insert(route, page);
+    }
+    if (!m_evictedIds.isEmpty())
+        m_evictedIds.remove(pathId(page->pagePath()));
+    if (!m_evictedParams.isEmpty()) {
+        auto it = m_evictedParams.find(page->pagePath());
+        if (it != m_evictedParams.end()) {
+            page->m_lastParams = it.value();
+            m_evictedParams.erase(it);
+        }
+    }
+    for (auto c : page->m_containers)
+        c->visitCreated([this](AbstractPage* p) { indexPage(p); });
+}
+
+inline void PagesManager::indexContainer(PagesContainer* container) {
+    if (!isAttached(container))
+        return;
+    container->visitCreated([this](AbstractPage* p) { indexPage(p); });
+}
+
+inline void PagesManager::unindexPage(AbstractPage* page, bool detach /*= true*/) {
+    for (auto c : page->m_containers)
+        c->visitCreated([this, detach](AbstractPage* p) { unindexPage(p, detach); });
+
+    // 只有已登记的(挂载在 root 之下的)页面才有索引和需要保留的参数; 按实例比较, 不误删同路径的其他页面
+    auto indexed = m_pathIndex.find(page->pagePath());
+    if (indexed != m_pathIndex.end() && indexed.value() == page) {
+        m_pathIndex.erase(indexed);
+        if (!page->m_lastParams.isEmpty())
+            m_evictedParams.insert(page->pagePath(), page->m_lastParams);
+        if (!isPooled(page))
+            m_routeIndex.remove(RouteId::fromShortcodePath(page->shortcodePath()));
+    }
+    if (!detach) {
+        page->m_lastParams.clear();
+        discardUpdates(page);
+        return;
+    }
+    m_factoryPages.remove(page);
+    if (!page->m_topics.isEmpty())
+        unsubscribeAll(page);
+    if (m_prewarmedPages.remove(page))
+        ++m_prewarmStats.wasted;
+}
+
+inline void PagesManager::forgetPages(AbstractPage* page) {
+    waitForPrepares(page);
+    if (m_currentPage && isDescendant(m_currentPage, page))
+        m_currentPage = nullptr;
+    if (m_snapshotTarget && isDescendant(m_snapshotTarget, page))
+        hideSnapshot();
+    unindexPage(page);
+}
+
+inline void PagesManager::pageDestroyed(AbstractPage* page) {
+    // 仍在容器中的页面是被直接销毁的, 连同子树一并注销; 容器析构时已注销其中的页面并置空 m_parent
+    if (page->m_parent) {
+        forgetPages(page);
+    }
+    else {
+        waitForPrepares(page);
+        m_factoryPages.remove(page);
+        m_prewarmedPages.remove(page);
+        if (!page->m_topics.isEmpty())
+            unsubscribeAll(page);
+    }
+    if (!page->m_deferredUpdates.isEmpty())
+        m_deferredPages.remove(page);
+}
+
+inline void PagesManager::containerDestroyed(PagesContainer* container) {
+    container->visitCreated([this](AbstractPage* p) { forgetPages(p); });
+    if (container == m_root) {
+        hideSnapshot();
+        m_root = nullptr;
+        m_currentPage = nullptr;
+    }
+}
+
+inline AbstractPage* PagesManager::acquirePooled(
+    PagesContainer* container, PagesContainer::PagePool& pool, const QString& name)
+{
+    AbstractPage* page = nullptr;
+    if (pool.members.size() >= pool.capacity) {
+        for (auto p : pool.members)
+            if ((!page || p->m_lastUsed < page->m_lastUsed) 
+                && p->m_state != AbstractPage::Active && !isPreparing(p))
+                page = p;
+    }
+
+    if (page) {
+        // 旧数据键的参数换出到 m_evictedParams, 重新绑定后由 indexPage() 换入新数据键的参数;
+        // 快照与准备结果呈现的是旧数据键的内容, 一并丢弃
+        if (m_snapshotTarget == page)
+            hideSnapshot();
+        m_snapshots.remove(pathId(page->pagePath()));
+        unindexPage(page, false);
+        page->m_prepared = false;
+        page->m_prepare = QFutureInterface<QVariant>();
+        ++m_poolStats.recycled;
+    }
+    else {
+        page = pool.factory();
+        Q_ASSERT(page);
+        if (page == nullptr)
+            return nullptr;
+        container->QStackedWidget::addWidget(page);
+        pool.members.append(page);
+        ++m_poolStats.created;
+        if (pool.members.size() == pool.capacity + 1)
+            m_overfullPools.append({ container, name.left(name.indexOf(':')) });
+    }
+
+    page->m_poolKey = name.mid(name.indexOf(':') + 1);
+    container->bindPage(name, pool.code, page);
+    return page;
+}
+
+inline void PagesManager::trimPools() {
+    auto overfull = std::move(m_overfullPools);
+    m_overfullPools.clear();
+    for (const auto& entry : overfull) {
+        PagesContainer* container = entry.first;
+        if (container == nullptr || !container->m_pools.contains(entry.second))
+            continue; // 容器已被销毁或页面池已被卸载
+
+        auto& pool = container->m_pools[entry.second];
+        while (pool.members.size() > pool.capacity) {
+            AbstractPage* victim = nullptr;
+            for (auto p : pool.members)
+                if ((!victim || p->m_lastUsed < victim->m_lastUsed)
+                    && p->m_state != AbstractPage::Active && !isPreparing(p))
+                    victim = p;
+            if (victim == nullptr) {
+                m_overfullPools.append(entry);
+                break;
+            }
+
+            // 与页面被直接销毁相同地移出页面池并重排容器中的位置, 参数保留在 m_evictedParams 中
+            forgetPages(victim);
+            container->forgetPage(victim);
+            container->QStackedWidget::removeWidget(victim);
+            victim->hide();
+            victim->deleteLater();
+            ++m_poolStats.trimmed;
+        }
+    }
+}
+
+inline void PagesManager::uninstallPages(PagesContainer* container, const QSet<QString>& names) {
+    // 路径是否位于被卸载的页面之下: 前缀为容器路径, 下一级为被卸载的名称(或页面池的路由)
+    auto parent = container->parentPage();
+    const QString prefix = parent ? parent->pagePath() : QString();
+    auto dead = [&](const QString& path) {
+        if (path.size() <= prefix.size() + 1 || !path.startsWith(prefix) || path[prefix.size()] != '/')
+            return false;
+        int end = path.indexOf('/', prefix.size() + 1);
+        QString hop = path.mid(prefix.size() + 1, end < 0 ? -1 : end - prefix.size() - 1);
+        int sep = hop.indexOf(':');
+        return names.contains(hop) || (sep > 0 && names.contains(hop.left(sep)));
+    };
+    const bool attached = isAttached(container);
+
+    // 当前页面被卸载时, 与切换离开时相同, 当前路径上仍处于激活状态的页面被挂起
+    if (attached && m_currentPage && dead(m_currentPage->pagePath())) {
+        PageHops previous;
+        collectHops(m_currentPage, previous);
+        for (auto page : previous) {
+            if (page->m_state == AbstractPage::Active) {
+                page->m_state = AbstractPage::Suspended;
+                traced(TraceSuspend, page, [page] { page->pageSuspend(); });
+            }
+        }
+        m_currentPage = nullptr;
+    }
+
+    // 页面随后被延迟销毁, 先等待其子树中仍在后台运行的准备任务结束
+    for (const auto& name : names) {
+        auto pool = container->m_pools.constFind(name);
+        if (pool != container->m_pools.constEnd()) {
+            for (auto page : pool->members) {
+                waitForPrepares(page);
+                unindexPage(page);
+            }
+        }
+        else if (auto page = qobject_cast<AbstractPage*>(container->widget(container->m_names.value(name)))) {
+            waitForPrepares(page);
+            unindexPage(page);
+        }
+    }
+    if (!attached)
+        return;
+
+    // 显示快照的页面已被销毁时, 覆盖层仍然可见, 一并移除
+    if (m_snapshotOverlay && (!m_snapshotTarget || dead(m_snapshotTarget->pagePath())))
+        hideSnapshot();
+
+    auto purge = [&](History& history) {
+        History kept(history.capacity());
+        for (int i = history.firstIndex(); !history.isEmpty() && i <= history.lastIndex(); ++i)
+            if (!dead(m_idPaths[int(history.at(i).pageId)]))
+                kept.append(history.at(i));
+        history = kept;
+    };
+    purge(m_stackBack);
+    purge(m_stackForward);
+
+    for (auto it = m_evictedParams.begin(); it != m_evictedParams.end(); ) {
+        if (dead(it.key()))
+            it = m_evictedParams.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = m_sessionParams.begin(); it != m_sessionParams.end(); ) {
+        if (dead(it.key()))
+            it = m_sessionParams.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = m_evictedIds.begin(); it != m_evictedIds.end(); ) {
+        if (dead(m_idPaths[int(*it)]))
+            it = m_evictedIds.erase(it);
+        else
+            ++it;
+    }
+    for (auto id : m_snapshots.keys())
+        if (dead(m_idPaths[int(id)]))
+            m_snapshots.remove(id);
+    m_prewarmQueue.erase(std::remove_if(m_prewarmQueue.begin(), m_prewarmQueue.end(),
+        [&](quint32 id) { return dead(m_idPaths[int(id)]); }), m_prewarmQueue.end());
+    m_pendingSwitches.erase(std::remove_if(m_pendingSwitches.begin(), m_pendingSwitches.end(),
+        [&](const PendingSwitch& request) { return dead(request.callee); }), m_pendingSwitches.end());
+
+    for (const auto& name : names)
+        emit pageUninstalled(prefix + "/" + name);
+}
+
+inline void PagesManager::startPrepare(AbstractPage* page) {
+    if (page->m_prepared)
+        return;
+    if (page->m_prepare.isRunning() && !page->m_prepare.isCanceled())
+        return;
+
+    QFutureInterface<QVariant> control;
+    control.reportStarted();
+    page->m_prepare = control;
+    m_preparing[page].append(control);
+    traced(TracePending, page, [page] { page->pagePending(); });
+
+    QPointer<AbstractPage> guard(page);
+    QVariantMap params = page->m_lastParams;
+    QThreadPool::globalInstance()->start([page, guard, params, control]() mutable {
+        // 任务结束之前页面及其上级页面不会被回收, 卸载时会先等待任务结束, 参见 m_preparing.
+        // pagePrepare() 返回之后不再访问 page.
+        if (!control.isCanceled())
+            control.reportResult(page->pagePrepare(params, [control] { return control.isCanceled(); }));
+
+        // 管理器析构时先清空实例指针再等待任务结束, 因此先投递再结束任务, 投递时管理器一定存活
+        if (auto manager = PagesManager::existingInstance()) {
+            QMetaObject::invokeMethod(manager, [page, guard, control] {
+                PagesManager::instance().finishPrepare(page, guard, control);
+            }, Qt::QueuedConnection);
+        }
+        control.reportFinished();
+    });
+}
+
+inline void PagesManager::finishPrepare(AbstractPage* key, QPointer<AbstractPage> page, QFutureInterface<QVariant> control) {
+    // 只按任务移除, 即使 key 已被销毁且地址被新页面复用也不会误删
+    auto it = m_preparing.find(key);
+    if (it != m_preparing.end()) {
+        it.value().removeOne(control);
+        if (it.value().isEmpty())
+            m_preparing.erase(it);
+    }
+
+    // 页面已被销毁、已开始新的准备或者准备被取消(下次访问时重新准备)时, 不采用本次结果
+    const bool adopted = !page.isNull() && page->m_prepare == control && !control.isCanceled();
+    if (adopted) {
+        page->m_prepared = true;
+        traced(TracePrepared, page.data(), [&] { page->pagePrepared(control.future().result()); });
+    }
+
+    // 无论结果是否被采用, 快照都不再等待本次准备; 页面已被销毁时 m_snapshotTarget 同样为空
+    if (m_snapshotOverlay && m_snapshotTarget == page)
+        hideSnapshot();
+    if (adopted)
+        emit pageReady(page->pagePath());
+}
+
+inline bool PagesManager::isPagePinned(AbstractPage* page, const QSet<QString>& history) const {
+    if (page->m_state == AbstractPage::Active || isPreparing(page))
+        return true;
+
+    for (auto p = m_currentPage; p; p = p->parentPage())
+        if (p == page)
+            return true;
+
+    return history.contains(page->pagePath());
+}
+
+inline QSet<QString> PagesManager::historyPaths() const {
+    QSet<QString> paths;
+    QSet<quint32> visited;
+    for (const History* history : { &m_stackBack, &m_stackForward }) {
+        for (int i = history->firstIndex(); !history->isEmpty() && i <= history->lastIndex(); ++i) {
+            quint32 id = history->at(i).pageId;
+            if (visited.contains(id))
+                continue;
+            visited.insert(id);
+            QString path = m_idPaths[int(id)];
+            for (int end = path.size(); end > 0; end = path.lastIndexOf('/', end - 1))
+                paths.insert(path.left(end));
+        }
+    }
+    return paths;
+}
+
+inline void PagesManager::enforcePageBudget() {
+    if (!m_overfullPools.isEmpty())
+        trimPools();
+    if (m_budgetPages == 0 && m_budgetBytes == 0)
+        return;
+
+    auto usage = [this] {
+        qint64 bytes = 0;
+        if (m_budgetBytes > 0)
+            for (auto p : m_factoryPages)
+                bytes += p->pageMemoryUsage();
+        return bytes;
+    };
+
+    qint64 bytes = usage();
+    const QSet<QString> history = historyPaths();
+    while ((m_budgetPages > 0 && m_factoryPages.size() > m_budgetPages) 
+        || (m_budgetBytes > 0 && bytes > m_budgetBytes))
+    {
+        AbstractPage* victim = nullptr;
+        for (auto p : m_factoryPages)
+            if ((!victim || p->m_lastUsed < victim->m_lastUsed) && !isPagePinned(p, history))
+                victim = p;
+        if (victim == nullptr)
+            break;
+
+        // 页面名称仍然安装在容器中, 保留其短码; 子树的短码引用转由容器保留, 使重新构造的子页面分配到相同的短码,
+        // 链接、书签与 RouteId 保持有效. 上一次回收时保留的引用此时释放, 与重新构造时增加的引用抵消
+        QString path = victim->pagePath();
+        evictPages(victim);
+        unindexPage(victim);
+        QVector<PagesContainer::HeldCode> held;
+        for (auto c : victim->m_containers)
+            c->collectShortcodes(held);
+        std::swap(held, victim->m_parent->m_heldCodes[victim->m_name]);
+        PagesContainer::releaseHeld(held);
+        victim->m_parent->releasePage(victim);
+        emit pageEvicted(path);
+
+        bytes = usage();
+    }
 }
 
 #endif // pages_manager_h__
@@ -0,0 +1,670 @@
+// Copyright (c) 2022-2024 Zero <zero.kwok@foxmail.com>
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pages_manager.hpp"
+#include <QtTest>
+#include <QBuffer>
+#include <QTemporaryDir>
+
+// PagesManager 的单元测试
+//
+// PagesManager 是单例, 每个测试用例在 init() 中安装新的根容器并清空历史,
+// cleanup() 中销毁整棵页面树.
+
+class TestPage : public AbstractPage
+{
+public:
+    void pageLazyInit() override { ++lazyInits; }
+    void pageEvict() override { ++evicts; }
+    void pageSuspend() override { ++suspends; }
+    void pageNotify(const QString&, const QVariantMap&) override {
+        ++notifies;
+        if (onNotify)
+            onNotify();
+    }
+
+    int lazyInits = 0;
+    int evicts = 0;
+    int suspends = 0;
+    int notifies = 0;
+    std::function<void()> onNotify;
+};
+
+class TestPagesManager : public QObject
+{
+    Q_OBJECT
+
+    PagesContainer* m_root = nullptr;
+
+    static PagesManager& manager() { return PagesManager::instance(); }
+
+    //! @brief 处理延迟销毁, 使 deleteLater() 的页面真正被销毁
+    static void flushDeletes() {
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+
+    //! @brief 在 parent 页面中安装一个容器并返回
+    static PagesContainer* addContainer(AbstractPage* parent) {
+        auto container = new PagesContainer(parent);
+        parent->installContainer(container);
+        return container;
+    }
+
+private slots:
+    void init() {
+        m_root = new PagesContainer();
+        manager().setRootContainer(m_root);
+        manager().clearHistory();
+    }
+
+    void cleanup() {
+        delete m_root;
+        m_root = nullptr;
+        flushDeletes();
+    }
+
+    void installAndLookup() {
+        auto home = new TestPage();
+        m_root->installPage("Home", home);
+        m_root->installPage("settings", [] { return new TestPage(); });
+
+        QCOMPARE(manager().page("/home"), static_cast<AbstractPage*>(home));
+        QCOMPARE(manager().page("HOME/"), static_cast<AbstractPage*>(home));
+        QVERIFY(manager().hasPage("/settings"));
+        QVERIFY(!manager().hasPage("/missing"));
+        QVERIFY(manager().page("/missing") == nullptr);
+
+        // 延迟页面只在首次访问时构造
+        QVERIFY(manager().existingPage("/settings") == nullptr);
+        QVERIFY(!m_root->isPageCreated("settings"));
+        auto settings = manager().page("/settings");
+        QVERIFY(settings);
+        QCOMPARE(manager().existingPage("/settings"), settings);
+        QCOMPARE(static_cast<TestPage*>(settings)->lazyInits, 1);
+        QVERIFY(manager().verifyPathIndex());
+    }
+
+    void nestedContainers() {
+        auto home = new TestPage();
+        m_root->installPage("home", home);
+        auto left = addContainer(home);
+        auto right = addContainer(home);
+        left->installPage("a", new TestPage());
+        right->installPage("b", new TestPage());
+
+        QCOMPARE(manager().page("/home/a")->pagePath(), QString("/home/a"));
+        QCOMPARE(manager().page("/home/b")->parentPage(), static_cast<AbstractPage*>(home));
+        QVERIFY(manager().verifyPathIndex());
+
+        // 先在游离的子树中安装页面, 再挂载到页面树中
+        auto detached = new TestPage();
+        auto inner = addContainer(detached);
+        inner->installPage("leaf", new TestPage());
+        QVERIFY(!manager().hasPage("/home/a/detached/leaf"));
+
+        addContainer(manager().page("/home/a"))->installPage("detached", detached);
+        QVERIFY(manager().existingPage("/home/a/detached/leaf"));
+        QCOMPARE(manager().page("/home/a/detached/leaf")->pagePath(), QString("/home/a/detached/leaf"));
+        QVERIFY(manager().verifyPathIndex());
+    }
+
+    void legacyShortcodePaths() {
+        auto outer = new TestPage();
+        m_root->installPageWithCode("oldroot", "or", outer);
+        addContainer(outer)->installPageWithCode("oldleaf", "ol", new TestPage());
+
+        QCOMPARE(manager().toShortcodePath("/oldroot/oldleaf"), QString("orol"));
+        QCOMPARE(manager().fromShortcodePath(QString("orol")), QString("/oldroot/oldleaf"));
+
+        // 旧版本中手写的大写两字符短码, 首字符按现在的字母表属于三字符短码
+        QCOMPARE(manager().fromShortcodePath(QString("OROL")), QString("/oldroot/oldleaf"));
+        QCOMPARE(manager().fromShortcodePath(QString("orOL")), QString("/oldroot/oldleaf"));
+        QCOMPARE(manager().fromShortcodePath(QString("OR")), QString("/oldroot"));
+        QVERIFY(manager().fromShortcodePath(QString("ORO")).isEmpty());
+    }
+
+    void legacyShortcodeOrder() {
+        // 与早期版本相同的分配顺序: 首字母 + 末字母, 名称中的字符组合, 单字符名称以其开头的短码, 再跳过首字母顺序查找
+        ShortcodeAllocator allocator;
+        QCOMPARE(allocator.allocate("home"), QString("he"));
+        QCOMPARE(allocator.allocate("hike"), QString("hi"));
+        QCOMPARE(allocator.allocate("aaa"), QString("aa"));
+        QCOMPARE(allocator.allocate("aaaa"), QString("ba"));
+        QCOMPARE(allocator.allocate("a"), QString("ab"));
+
+        // 回收的短码在顺序查找中被重新使用
+        QVERIFY(allocator.release("aaaa"));
+        QCOMPARE(allocator.allocate("aaaaa"), QString("ba"));
+    }
+
+    void uninstallPages() {
+        for (auto name : { "a", "b", "c", "d" })
+            m_root->installPage(name, new TestPage());
+        addContainer(manager().page("/b"))->installPage("child", new TestPage());
+        m_root->installPage("lazy", [] { return new TestPage(); });
+
+        manager().pageGoto({}, "/a", {});
+        manager().pageGoto("/a", "/b/child", {});
+        manager().pageGoto("/b/child", "/c", {});
+        QCOMPARE(manager().backCount(), 2);
+
+        m_root->uninstallPages({ "b", "lazy" });
+        flushDeletes();
+
+        QVERIFY(!manager().hasPage("/b"));
+        QVERIFY(!manager().hasPage("/b/child"));
+        QVERIFY(!manager().hasPage("/lazy"));
+        QVERIFY(manager().verifyPathIndex());
+
+        // 剩余页面的位置被重排, 仍然指向正确的控件
+        for (auto name : { "a", "c", "d" }) {
+            auto page = m_root->page(name);
+            QVERIFY(page);
+            QCOMPARE(page->name(), QString(name));
+            m_root->setCurrentPage(name);
+            QCOMPARE(m_root->currentWidget(), static_cast<QWidget*>(page));
+        }
+
+        // 历史中指向被卸载页面的记录被清除
+        QCOMPARE(manager().backCount(), 1);
+        QCOMPARE(manager().pathOf(manager().backEntry(0).pageId), QString("/a"));
+
+        // 名称可以重新安装
+        m_root->installPage("b", new TestPage());
+        QVERIFY(manager().hasPage("/b"));
+        QVERIFY(manager().verifyPathIndex());
+    }
+
+    void uninstallCurrentPage() {
+        auto home = new TestPage();
+        m_root->installPage("home", home);
+        auto x = new TestPage();
+        auto container = addContainer(home);
+        container->installPage("x", x);
+
+        manager().pageSwitch({}, "/home/x", {});
+        QCOMPARE(manager().currentPage(), static_cast<AbstractPage*>(x));
+        QCOMPARE(home->pageState(), AbstractPage::Active);
+
+        // 当前路径上的页面与切换离开时一样被挂起
+        container->uninstallPage("x");
+        QVERIFY(manager().currentPage() == nullptr);
+        QCOMPARE(home->pageState(), AbstractPage::Suspended);
+        QCOMPARE(home->suspends, 1);
+        QCOMPARE(x->suspends, 1);
+        flushDeletes();
+        QVERIFY(manager().verifyPathIndex());
+    }
+
+    void evictSubtree() {
+        m_root->installPage("a", [] {
+            auto page = new TestPage();
+            auto container = new PagesContainer(page);
+            page->installContainer(container);
+            container->installPage("evictchild", new TestPage());
+            return page;
+        });
+        m_root->installPage("b", [] { return new TestPage(); });
+
+        auto child = static_cast<TestPage*>(manager().page("/a/evictchild"));
+        auto a = static_cast<TestPage*>(manager().page("/a"));
+        auto& shortcodes = a->containers().values().first()->shortcodes();
+        const QString code = manager().toShortcodePath("/a/evictchild");
+        QVERIFY(!shortcodes.pageCode("evictchild").isEmpty());
+
+        manager().pageSwitch({}, "/b", {});
+        manager().setPageBudget(1);
+
+        // 子页面随之回收: 触发 pageEvict(), 标记为 Evicted, 子容器的短码仍被保留
+        QCOMPARE(a->evicts, 1);
+        QCOMPARE(child->evicts, 1);
+        QCOMPARE(manager().pageState("/a"), AbstractPage::Evicted);
+        QCOMPARE(manager().pageState("/a/evictchild"), AbstractPage::Evicted);
+        QVERIFY(!shortcodes.pageCode("evictchild").isEmpty());
+        QVERIFY(!m_root->isPageCreated("a"));
+        flushDeletes();
+        QVERIFY(manager().verifyPathIndex());
+
+        // 重新访问时整棵子树被重新构造, 短码路径不变; 反复回收与重新构造不会累积短码引用
+        for (int i = 0; i < 3; ++i) {
+            manager().setPageBudget(0);
+            QVERIFY(manager().page("/a/evictchild"));
+            QCOMPARE(manager().toShortcodePath("/a/evictchild"), code);
+            QVERIFY(manager().verifyPathIndex());
+            manager().pageSwitch({}, "/b", {});
+            manager().setPageBudget(1);
+            QVERIFY(!m_root->isPageCreated("a"));
+            flushDeletes();
+        }
+        m_root->uninstallPage("a");
+        flushDeletes();
+        QVERIFY(ShortcodeAllocator::instance().pageCode("evictchild").isEmpty());
+    }
+
+    void treeModelEviction() {
+        m_root->installPage("a", [] {
+            auto page = new TestPage();
+            auto container = new PagesContainer(page);
+            page->installContainer(container);
+            container->installPage("modelchild", new TestPage());
+            return page;
+        });
+        m_root->installPage("b", [] { return new TestPage(); });
+        PagesTreeModel model;
+        QVERIFY(manager().page("/a/modelchild"));
+        QCOMPARE(model.rowCount(model.indexOf("/a")), 1);
+
+        // 回收的页面保留为延迟页面的行, 其子孙页面的行被移除, 重新构造时再插入
+        manager().pageSwitch({}, "/b", {});
+        manager().setPageBudget(1);
+        QVERIFY(model.indexOf("/a").isValid());
+        QCOMPARE(model.rowCount(model.indexOf("/a")), 0);
+        QVERIFY(!model.indexOf("/a/modelchild").isValid());
+        flushDeletes();
+        manager().setPageBudget(0);
+        QVERIFY(manager().page("/a/modelchild"));
+        QVERIFY(model.indexOf("/a/modelchild").isValid());
+
+        // 直接销毁的页面与卸载相同地移除其行
+        delete manager().page("/b");
+        QVERIFY(!model.indexOf("/b").isValid());
+        QCOMPARE(model.rowCount(), 1);
+    }
+
+    void poolRebinding() {
+        m_root->installPage("home", new TestPage());
+        m_root->installPagePool("device", [] { return new TestPage(); }, 1);
+
+        auto a = manager().page("/device:a");
+        QVERIFY(a);
+        QCOMPARE(a->poolKey(), QString("a"));
+        QVERIFY(manager().routeId("/device:a").isNull());
+        QVERIFY(manager().toShortcodePath("/device:a").isEmpty());
+
+        // 不在屏幕上的实例推迟更新, 重新绑定到其他数据键时旧键的更新被丢弃
+        manager().pageSwitch({}, "/home", {});
+        const int discarded = manager().updateStats().discarded;
+        bool ran = false;
+        QVERIFY(!a->deferUpdate("model", [&ran] { ran = true; }));
+        QCOMPARE(a->pendingUpdates(), 1);
+
+        QCOMPARE(manager().page("/device:b"), a);
+        QCOMPARE(a->poolKey(), QString("b"));
+        QCOMPARE(a->pendingUpdates(), 0);
+        QCOMPARE(manager().updateStats().discarded, discarded + 1);
+        a->flushUpdates();
+        QVERIFY(!ran);
+        QVERIFY(manager().verifyPathIndex());
+    }
+
+    void poolOverCapacity() {
+        m_root->installPage("home", new TestPage());
+        m_root->installPagePool("device", [] { return new TestPage(); }, 1);
+        const auto stats = manager().poolStats();
+
+        // 切换时唯一的实例仍在当前路径上, 池临时超出容量; 导航结束后旧实例被销毁
+        manager().pageSwitch({}, "/device:a", {});
+        QPointer<AbstractPage> a = manager().page("/device:a");
+        QVERIFY(a);
+        manager().pageSwitch("/device:a", "/device:b", {});
+        QPointer<AbstractPage> b = manager().page("/device:b");
+        QVERIFY(b && b != a);
+        QCOMPARE(manager().poolStats().created, stats.created + 2);
+        QCOMPARE(manager().poolStats().trimmed, stats.trimmed + 1);
+        flushDeletes();
+        QVERIFY(a.isNull());
+        QCOMPARE(m_root->currentWidget(), static_cast<QWidget*>(b.data()));
+        QVERIFY(manager().verifyPathIndex());
+
+        // 回到容量之内, 不在当前路径上的实例照常被重新绑定
+        manager().pageSwitch("/device:b", "/home", {});
+        QCOMPARE(manager().page("/device:c"), b.data());
+        QCOMPARE(manager().poolStats().created, stats.created + 2);
+        QCOMPARE(manager().poolStats().trimmed, stats.trimmed + 1);
+        QVERIFY(manager().verifyPathIndex());
+    }
+
+    void uninstallContainer() {
+        auto home = new TestPage();
+        m_root->installPage("home", home);
+        auto container = addContainer(home);
+        container->installPage("x", new TestPage());
+        addContainer(manager().page("/home/x"))->installPage("y", new TestPage());
+        QVERIFY(manager().existingPage("/home/x/y"));
+
+        home->uninstallContainer(container);
+        flushDeletes();
+
+        QVERIFY(home->containers().isEmpty());
+        QVERIFY(!manager().hasPage("/home/x"));
+        QVERIFY(!manager().hasPage("/home/x/y"));
+        QCOMPARE(manager().page("/home"), static_cast<AbstractPage*>(home));
+        QVERIFY(manager().verifyPathIndex());
+    }
+
+    void destroyPagesDirectly() {
+        for (auto name : { "a", "b", "c" })
+            m_root->installPage(name, new TestPage());
+        addContainer(manager().page("/b"))->installPage("child", new TestPage());
+        manager().pageGoto({}, "/b/child", {});
+
+        // 直接销毁页面与卸载相同: 子树被注销, 剩余页面的位置被重排
+        delete manager().page("/b");
+        QVERIFY(!manager().hasPage("/b"));
+        QVERIFY(!manager().hasPage("/b/child"));
+        QVERIFY(manager().currentPage() == nullptr);
+        QVERIFY(manager().verifyPathIndex());
+        m_root->setCurrentPage("c");
+        QCOMPARE(m_root->currentWidget(), static_cast<QWidget*>(manager().page("/c")));
+        m_root->installPage("b", new TestPage());
+        QVERIFY(manager().hasPage("/b"));
+
+        // 直接销毁 root 后, 新的 root 上不会残留已销毁的实例与订阅
+        manager().page("/a")->subscribe("topic");
+        delete m_root;
+        QCOMPARE(manager().subscriberCount("topic"), 0);
+        m_root = new PagesContainer();
+        manager().setRootContainer(m_root);
+        QVERIFY(!manager().hasPage("/a"));
+        QVERIFY(manager().verifyPathIndex());
+        m_root->installPage("a", new TestPage());
+        QVERIFY(manager().page("/a") != nullptr);
+        QVERIFY(manager().verifyPathIndex());
+    }
+
+    void clearBackAndForward() {
+        for (auto name : { "a", "b", "c" })
+            m_root->installPage(name, new TestPage());
+        manager().pageGoto({}, "/a", {});
+        manager().pageGoto("/a", "/b", {});
+        manager().pageGoto("/b", "/c", {});
+        manager().pageBack("/c", {});
+        QCOMPARE(manager().backCount(), 1);
+        QCOMPARE(manager().forwardCount(), 1);
+
+        manager().clearForward();
+        QVERIFY(!manager().canForward());
+        QCOMPARE(manager().backCount(), 1);
+
+        manager().clearBack();
+        QVERIFY(!manager().canBack());
+    }
+
+    void publishSkipsRemovedSubscribers() {
+        auto a = new TestPage();
+        auto b = new TestPage();
+        auto c = new TestPage();
+        auto d = new TestPage();
+        m_root->installPage("a", a);
+        m_root->installPage("b", b);
+        m_root->installPage("c", c);
+        m_root->installPage("d", d);
+        const AbstractPage::NotifyFlags flags = AbstractPage::NotifyInactive | AbstractPage::NotifyUninitialized;
+        for (auto page : { a, b, c, d })
+            page->subscribe("topic", flags);
+
+        // 第一个订阅者卸载 b 并直接销毁 c, 二者在同一次发布中都不再收到通知
+        a->onNotify = [this, c] {
+            m_root->uninstallPage("b");
+            delete c;
+        };
+        QCOMPARE(manager().publish("topic", {}), 2);
+        QCOMPARE(a->notifies, 1);
+        QCOMPARE(b->notifies, 0);
+        QCOMPARE(d->notifies, 1);
+        QCOMPARE(manager().subscriberCount("topic"), 2);
+        a->onNotify = nullptr;
+        flushDeletes();
+    }
+
+    void replayWithPageParam() {
+        m_root->installPage("a", new TestPage());
+        m_root->installPage("b", new TestPage());
+
+        QBuffer buffer;
+        buffer.open(QIODevice::ReadWrite);
+        manager().startRecording(&buffer);
+        manager().pageGoto({}, "/a", {});
+        manager().pageGoto("/a", "/b", {
+            { "id", 3 },
+            { "table", PageParam::wrap(QVector<int>{ 1, 2, 3 }) },
+            { "nested", QVariantMap{ { "n", 1 }, { "blob", PageParam::wrap(1) } } },
+            { "hash", QVariantHash{ { "h", 2 }, { "blob", PageParam::wrap(2) } } },
+        });
+        manager().pageBack("/b", {});
+        manager().stopRecording();
+
+        // 目标页面收到完整的参数, 记录中只保留可以序列化的部分
+        QVERIFY(PageParam::peek<QVector<int>>(manager().page("/b")->lastParams().value("table")));
+
+        buffer.seek(0);
+        NavigationReplayer replayer;
+        QVERIFY(replayer.load(&buffer));
+        QCOMPARE(replayer.steps().size(), 3);
+        const QVariantMap& recorded = replayer.steps().at(1).params;
+        QCOMPARE(recorded.value("id").toInt(), 3);
+        QVERIFY(!recorded.contains("table"));
+        const QVariantMap nested = recorded.value("nested").toMap();
+        QCOMPARE(nested.size(), 1);
+        QCOMPARE(nested.value("n").toInt(), 1);
+        const QVariantHash hash = recorded.value("hash").toHash();
+        QCOMPARE(hash.size(), 1);
+        QCOMPARE(hash.value("h").toInt(), 2);
+
+        manager().clearHistory();
+        auto report = replayer.replay();
+        QCOMPARE(report.steps, 3);
+        QCOMPARE(report.skipped, 0);
+        QCOMPARE(manager().page("/b")->lastParams().value("id").toInt(), 3);
+    }
+
+    void replaySkipsMissingPages() {
+        auto install = [this](bool withInner) {
+            m_root->installPage("home", new TestPage());
+            m_root->installPage("lazy", [withInner] {
+                auto page = new TestPage();
+                auto container = new PagesContainer(page);
+                page->installContainer(container);
+                if (withInner)
+                    container->installPage("inner", new TestPage());
+                return page;
+            });
+        };
+        install(true);
+
+        QBuffer buffer;
+        buffer.open(QIODevice::ReadWrite);
+        manager().startRecording(&buffer);
+        manager().pageGoto({}, "/home", {});
+        manager().pageGoto("/home", "/lazy/inner", {});
+        manager().pageInvoke("/lazy/inner", "/lazy/inner", {});
+        manager().pageSwitch({}, "/home", {});
+        manager().stopRecording();
+
+        // 重建页面树, 延迟页面不再构造 inner; hasPage() 在构造之前仍然认为路径存在
+        delete m_root;
+        flushDeletes();
+        m_root = new PagesContainer();
+        manager().setRootContainer(m_root);
+        manager().clearHistory();
+        install(false);
+        QVERIFY(manager().hasPage("/lazy/inner"));
+
+        buffer.seek(0);
+        NavigationReplayer replayer;
+        QVERIFY(replayer.load(&buffer));
+        auto report = replayer.replay();
+        QCOMPARE(report.steps, 4);
+        QCOMPARE(report.skipped, 2);
+        QVERIFY(!manager().pageInvoke({}, "/lazy/inner", {}).isValid());
+        QCOMPARE(manager().currentPage()->pagePath(), QString("/home"));
+    }
+
+    void restoreMissingCurrentPage() {
+        auto install = [this](bool withInner) {
+            m_root->installPage("home", new TestPage());
+            m_root->installPage("lazy", [withInner] {
+                auto page = new TestPage();
+                auto container = new PagesContainer(page);
+                page->installContainer(container);
+                if (withInner)
+                    container->installPage("inner", new TestPage());
+                return page;
+            });
+        };
+        install(true);
+        manager().pageGoto({}, "/home", {});
+        manager().pageGoto("/home", "/lazy/inner", {});
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.filePath("session.bin");
+        QVERIFY(manager().saveSession(fileName));
+
+        delete m_root;
+        flushDeletes();
+        m_root = new PagesContainer();
+        manager().setRootContainer(m_root);
+        manager().clearHistory();
+        install(false);
+
+        // 保存时的当前页面已不存在: 会话仍然恢复, 但不切换
+        QVERIFY(manager().restoreSession(fileName));
+        QVERIFY(manager().currentPage() == nullptr);
+        QCOMPARE(manager().backCount(), 1);
+    }
+
+    void parseLinks() {
+        auto view = new TestPage();
+        m_root->installPage("view", view);
+        auto container = addContainer(view);
+        container->installPage("photos", [] { return new TestPage(); });
+        container->setParamSchema("photos", {
+            { "device", QMetaType::Int, true },
+            { "sort", QMetaType::QString, false },
+        });
+
+        auto link = manager().parseLink(QString("/View/Photos?device=3&sort=a%20b&view.layout=grid#top"));
+        QVERIFY2(link.isValid(), qPrintable(link.error));
+        QCOMPARE(link.path, QString("/view/photos"));
+        QCOMPARE(link.params.value("device").userType(), int(QMetaType::Int));
+        QCOMPARE(link.params.value("device").toInt(), 3);
+        QCOMPARE(link.params.value("sort").toString(), QString("a b"));
+        QCOMPARE(link.params.value("/view").toMap().value("layout").toString(), QString("grid"));
+
+        // 短码路径
+        const QString code = manager().toShortcodePath("/view/photos");
+        QVERIFY(!code.isEmpty());
+        QCOMPARE(manager().parseLink(code + "?device=1").path, QString("/view/photos"));
+
+        // 校验失败: 缺少必需参数, 未声明的参数, 类型不符, 页面不存在
+        const QStringList errors = manager().validateLinks({
+            "/view/photos?device=1",
+            "/view/photos?sort=date",
+            "/view/photos?device=1&bogus=1",
+            "/view/photos?device=abc",
+            "/view/missing",
+        });
+        QCOMPARE(errors.size(), 5);
+        QVERIFY(errors[0].isEmpty());
+        for (int i = 1; i < errors.size(); ++i)
+            QVERIFY2(!errors[i].isEmpty(), qPrintable(QString::number(i)));
+
+        // 解析与校验不会构造延迟页面
+        QVERIFY(!container->isPageCreated("photos"));
+        QVERIFY(manager().openLink({}, QString("/view/photos?device=7")));
+        QCOMPARE(manager().currentPage()->pagePath(), QString("/view/photos"));
+        QCOMPARE(manager().currentPage()->lastParams().value("device").toInt(), 7);
+
+        // 尚未构造的延迟页面之下的路径无法确认
+        container->installPage("album", [] {
+            auto page = new TestPage();
+            auto inner = new PagesContainer(page);
+            page->installContainer(inner);
+            inner->installPage("known", new TestPage());
+            return page;
+        });
+        QVector<bool> verified;
+        const QStringList lazyErrors = manager().validateLinks({
+            "/view/album",
+            "/view/album/bogus",
+            "/view/album/known",
+        }, &verified);
+        QCOMPARE(lazyErrors, QStringList({ QString(), QString(), QString() }));
+        QCOMPARE(verified, QVector<bool>({ true, false, false }));
+        QVERIFY(!container->isPageCreated("album"));
+
+        // 打开时构造路径上的页面后重新校验, 不存在的页面返回 false 而不发生跳转
+        QVERIFY(!manager().openLink({}, QString("/view/album/bogus")));
+        QCOMPARE(manager().currentPage()->pagePath(), QString("/view/photos"));
+        QVERIFY(container->isPageCreated("album"));
+        QVERIFY(!manager().parseLink(QString("/view/album/bogus")).isValid());
+        QVERIFY(manager().parseLink(QString("/view/album/known")).verified);
+        QVERIFY(manager().openLink({}, QString("/view/album/known")));
+        QCOMPARE(manager().currentPage()->pagePath(), QString("/view/album/known"));
+    }
+
+    void sessionRoundTrip() {
+        auto install = [this] {
+            m_root->installPage("a", new TestPage());
+            m_root->installPage("b", new TestPage());
+            m_root->installPage("c", [] { return new TestPage(); });
+        };
+        install();
+        manager().setHistorySnapshots(true);
+        manager().pageGoto({}, "/a", {});
+        manager().pageGoto("/a", "/b", { { "id", 3 }, { "table", PageParam::wrap(QString("rows")) } });
+        manager().page("/c")->lastParams().insert("x", 5);
+        manager().pageGoto("/b", "/a", { { "blob", PageParam::wrap(1) } });
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.filePath("session.bin");
+        QVERIFY(manager().saveSession(fileName));
+
+        // 模拟重新启动: 重建页面树后恢复会话
+        delete m_root;
+        flushDeletes();
+        m_root = new PagesContainer();
+        manager().setRootContainer(m_root);
+        manager().clearHistory();
+        install();
+
+        QVERIFY(manager().restoreSession(fileName, false));
+        QCOMPARE(manager().backCount(), 2);
+        QCOMPARE(manager().pathOf(manager().backEntry(0).pageId), QString("/b"));
+        QCOMPARE(manager().backEntry(0).params.value("id").toInt(), 3);
+        QVERIFY(!manager().backEntry(0).params.contains("table"));
+
+        // 无法序列化的参数被剔除, 其余参数在页面首次被访问时应用
+        const QVariantMap b = manager().page("/b")->lastParams();
+        QCOMPARE(b.value("id").toInt(), 3);
+        QVERIFY(!b.contains("table"));
+        QVERIFY(!manager().page("/a")->lastParams().contains("blob"));
+        QCOMPARE(manager().page("/c")->lastParams().value("x").toInt(), 5);
+
+        // 可以覆盖当前映射着的快照文件
+        QVERIFY(manager().saveSession(fileName));
+        manager().setHistorySnapshots(false);
+    }
+};
+
+QTEST_MAIN(TestPagesManager)
+#include "tst_pages_manager.moc"